@@ -0,0 +1,94 @@
+#include "Attacks.h"
+
+// Magic numbers that map every blocker arrangement of a square to its own slot
+// (or to a slot holding the same attacks). Found once by trying random sparse numbers.
+static const uint64_t rookMagics[64] = {
+    0x3080004000802010ull, 0x0C40029005C02004ull, 0x4080100259200080ull, 0x1100042009021000ull,
+    0x2100030010080004ull, 0x1200860044001810ull, 0x0400080110008402ull, 0x2200008040240102ull,
+    0x0000800020804004ull, 0x0184804000200480ull, 0x0848801004200080ull, 0x1001001001002008ull,
+    0x8001000408001100ull, 0x0101000802040100ull, 0x4285001401000200ull, 0x008180010020C080ull,
+    0x0000228000400080ull, 0x0810004000402000ull, 0x0010008020008018ull, 0x1400090021021000ull,
+    0x820A808004000802ull, 0x0404008002008004ull, 0x0202008080020100ull, 0x094402000C025181ull,
+    0x0280400080008020ull, 0x0200200040401000ull, 0x0404482200108200ull, 0x00081022000A0040ull,
+    0x1000040080800800ull, 0x0182000200058810ull, 0x0000827400481021ull, 0x0000008200091064ull,
+    0x0040004020800089ull, 0x648E024102002082ull, 0x0000200080801000ull, 0x001200419200200Aull,
+    0x0430080080800400ull, 0x0000040080800200ull, 0x002201100400D802ull, 0x5800404082000401ull,
+    0x0000400080008020ull, 0x0140028020018044ull, 0x4004801204420020ull, 0x080210030021000Aull,
+    0x2204000408008080ull, 0x020A000804020010ull, 0x0100010002008080ull, 0x2000440040820001ull,
+    0x0000408000210100ull, 0x4000810028420200ull, 0x0A8020010043B100ull, 0x0100201000090100ull,
+    0x0001021048004500ull, 0x0002020080040080ull, 0x0048080102100400ull, 0x00410000A2084100ull,
+    0x0040110222004682ull, 0x0802002100408012ull, 0x0420040820401101ull, 0x8040200805001001ull,
+    0x0045000218001035ull, 0x840A001001080482ull, 0x0800420081300804ull, 0x0400008100402412ull,
+};
+
+static const uint64_t bishopMagics[64] = {
+    0x0002200800808083ull, 0x082401020E120004ull, 0x001000A208400000ull, 0x4024052600949040ull,
+    0x0002021100000101ull, 0x00220802080C0000ull, 0x000C014108210908ull, 0x024A049080901001ull,
+    0x0043C20411020210ull, 0x002020213A248100ull, 0x09224942040D0183ull, 0x01000C4220802000ull,
+    0x0041820211000400ull, 0x3000320802080800ull, 0x030084010402A000ull, 0x0210004C04040200ull,
+    0x0010014430220820ull, 0x0002042008010904ull, 0x08A0403008404040ull, 0x0260202202004000ull,
+    0x2004005211200800ull, 0x08048060C8044000ull, 0x004B003209012040ull, 0x0460802042009004ull,
+    0x2002080EC0110440ull, 0x0018022004948800ull, 0x0008404008060040ull, 0x1821080001004300ull,
+    0x0001020044008401ull, 0x4010004040241008ull, 0x0004040000A08404ull, 0x000CB10082004200ull,
+    0x6001100800112000ull, 0x06181110A4148400ull, 0x0004002480480204ull, 0x1200400808608200ull,
+    0x00A8020400001010ull, 0xC220040020010090ull, 0x00018A0080440C10ull, 0x8002020040002401ull,
+    0x180101109030C040ull, 0x8010884108801000ull, 0x0013420050048100ull, 0x010021A018008101ull,
+    0x8040080904440401ull, 0x1042240804200A00ull, 0x404802E082018400ull, 0x0010008200480089ull,
+    0x0004008404201228ull, 0x090042280402000Aull, 0x0248108888210800ull, 0x0005800E05042404ull,
+    0x08000808A1010030ull, 0x0208A02202060A10ull, 0x00C0481901461048ull, 0x00221042418104A0ull,
+    0x88084400808820C2ull, 0x0000408448421040ull, 0x0880200242009038ull, 0x0C41020080208800ull,
+    0x0000880520A24410ull, 0x00001041C4080A21ull, 0x0000295810108200ull, 0x0011201A00460020ull,
+};
+
+SliderEntry bishopEntries[64];
+SliderEntry rookEntries[64];
+
+// every square's attack sets, one after another
+static uint64_t bishopTable[5248];
+static uint64_t rookTable[102400];
+
+// The squares on a slider's rays that can block it, the last square of a ray
+// can't block anything behind it so it is left out.
+static uint64_t blockerMask(int index, const Direction* directions) {
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; i++) {
+        uint64_t ray = attacks.rays[directions[i]][index];
+        if (!ray)
+            continue;
+        uint64_t edge = (directions[i] < SOUTH) ? (uint64_t(1) << (63 - std::countl_zero(ray))) : (ray & (~ray + 1));
+        mask |= ray & ~edge;
+    }
+    return mask;
+}
+
+static void fillEntries(SliderEntry* entries, uint64_t* table, const uint64_t* magics, const Direction* directions) {
+    uint64_t* next = table;
+    for (int index = 0; index < 64; index++) {
+        SliderEntry& entry = entries[index];
+        entry.mask = blockerMask(index, directions);
+        entry.magic = magics[index];
+        entry.shift = 64 - std::popcount(entry.mask);
+        entry.attacks = next;
+        next += uint64_t(1) << std::popcount(entry.mask);
+
+        // walk every subset of the mask (the Carry-Rippler trick) and store its attacks
+        uint64_t blockers = 0;
+        do {
+            uint64_t attacked = 0;
+            for (int i = 0; i < 4; i++)
+                attacked |= rayAttacks(directions[i], index, blockers);
+            entry.attacks[entry.index(blockers)] = attacked;
+            blockers = (blockers - entry.mask) & entry.mask;
+        } while (blockers);
+    }
+}
+
+static bool initSliders() {
+    const Direction bishopDirections[4] = { NORTH_EAST, NORTH_WEST, SOUTH_EAST, SOUTH_WEST };
+    const Direction rookDirections[4] = { NORTH, EAST, SOUTH, WEST };
+    fillEntries(bishopEntries, bishopTable, bishopMagics, bishopDirections);
+    fillEntries(rookEntries, rookTable, rookMagics, rookDirections);
+    return true;
+}
+
+[[maybe_unused]] static const bool slidersReady = initSliders();
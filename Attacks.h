@@ -0,0 +1,117 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#if defined(CHESS_USE_PEXT)
+#include <immintrin.h>
+#endif
+
+// Which squares every piece attacks from every square.
+// Bit index is y * 8 + x like the rest of the Bitboards (see Board.h).
+// The leaper tables and rays are worked out at compile time, the sliding piece
+// tables (see below) when the program starts.
+
+// the eight sliding directions, the first four go up the board (to higher square indices)
+enum Direction {
+    NORTH,
+    NORTH_EAST,
+    EAST,
+    NORTH_WEST,
+    SOUTH,
+    SOUTH_WEST,
+    WEST,
+    SOUTH_EAST,
+};
+
+struct AttackTables {
+    uint64_t knight[64];
+    uint64_t king[64];
+    uint64_t pawn[2][64]; // by team, the squares a pawn captures on
+    uint64_t rays[8][64]; // by Direction, every square up to the edge of the board
+};
+
+constexpr uint64_t stepsFrom(int index, const int (*steps)[2], int count, bool slide) {
+    uint64_t ret = 0;
+    for (int i = 0; i < count; i++) {
+        int x = index % 8 + steps[i][0];
+        int y = index / 8 + steps[i][1];
+        while (x >= 0 && x <= 7 && y >= 0 && y <= 7) {
+            ret |= uint64_t(1) << (y * 8 + x);
+            if (!slide)
+                break;
+            x += steps[i][0];
+            y += steps[i][1];
+        }
+    }
+    return ret;
+}
+
+constexpr AttackTables makeAttackTables() {
+    const int knightSteps[8][2] = { {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2} };
+    const int kingSteps[8][2] = { {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1} };
+    const int whitePawnSteps[2][2] = { {-1, 1}, {1, 1} };
+    const int blackPawnSteps[2][2] = { {-1, -1}, {1, -1} };
+    // in Direction order
+    const int raySteps[8][2] = { {0, 1}, {1, 1}, {1, 0}, {-1, 1}, {0, -1}, {-1, -1}, {-1, 0}, {1, -1} };
+
+    AttackTables tables = {};
+    for (int index = 0; index < 64; index++) {
+        tables.knight[index] = stepsFrom(index, knightSteps, 8, false);
+        tables.king[index] = stepsFrom(index, kingSteps, 8, false);
+        tables.pawn[0][index] = stepsFrom(index, whitePawnSteps, 2, false);
+        tables.pawn[1][index] = stepsFrom(index, blackPawnSteps, 2, false);
+        for (int direction = 0; direction < 8; direction++)
+            tables.rays[direction][index] = stepsFrom(index, &raySteps[direction], 1, true);
+    }
+    return tables;
+}
+
+inline constexpr AttackTables attacks = makeAttackTables();
+
+// A ray stops at (and includes) the first occupied square on it.
+// Walking rays is only used to fill the sliding tables, the lookups below are faster.
+inline uint64_t rayAttacks(Direction direction, int index, uint64_t occupied) {
+    uint64_t ray = attacks.rays[direction][index];
+    uint64_t blockers = ray & occupied;
+    if (blockers) {
+        int blocker = (direction < SOUTH) ? std::countr_zero(blockers) : 63 - std::countl_zero(blockers);
+        ray ^= attacks.rays[direction][blocker];
+    }
+    return ray;
+}
+
+// Sliding attacks are looked up by the pieces that could block them:
+// the blockers on a square's rays (minus the board edges, which never matter) are squashed
+// into an index, either by multiplying with a 'magic' number that packs them into the top bits
+// or, when built with CHESS_USE_PEXT, by the BMI2 pext instruction that does it in one step.
+struct SliderEntry {
+    uint64_t mask;
+    uint64_t magic;
+    uint64_t* attacks;
+    int shift;
+
+    unsigned index(uint64_t occupied) const {
+#if defined(CHESS_USE_PEXT)
+        return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+// filled in Attacks.cpp
+extern SliderEntry bishopEntries[64];
+extern SliderEntry rookEntries[64];
+
+inline uint64_t bishopAttacks(int index, uint64_t occupied) {
+    const SliderEntry& entry = bishopEntries[index];
+    return entry.attacks[entry.index(occupied)];
+}
+
+inline uint64_t rookAttacks(int index, uint64_t occupied) {
+    const SliderEntry& entry = rookEntries[index];
+    return entry.attacks[entry.index(occupied)];
+}
+
+inline uint64_t queenAttacks(int index, uint64_t occupied) {
+    return bishopAttacks(index, occupied) | rookAttacks(index, occupied);
+}
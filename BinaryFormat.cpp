@@ -0,0 +1,213 @@
+#include "BinaryFormat.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const char magic[8] = { 'C', 'H', 'E', 'S', 'S', 'B', 'I', 'N' };
+    const uint32_t version = 1;
+
+    // game records start on 8 byte boundaries
+    uint64_t gameSize(uint32_t moveCount) {
+        return (sizeof(GameHeader) + moveCount * sizeof(uint16_t) + 7) & ~uint64_t(7);
+    }
+
+    // one king a team and no pawns on the first or last rank, what the move generator relies on
+    bool playable(const Board& board) {
+        const Bitboard backRanks = 0xff000000000000ffULL;
+        return std::popcount(board.piecesOf(Teams::WHITE, PieceType::KING)) == 1
+            && std::popcount(board.piecesOf(Teams::BLACK, PieceType::KING)) == 1
+            && !(board.pieces[static_cast<int>(PieceType::PAWN)] & backRanks);
+    }
+
+    // the king and rook a castling right needs are on their starting squares
+    bool castlingPiecesInPlace(const Board& board, int right) {
+        Teams color = (right & (WHITE_SHORT | WHITE_LONG)) ? Teams::WHITE : Teams::BLACK;
+        int rank = color == Teams::WHITE ? 0 : 56;
+        int rook = rank + ((right & (WHITE_SHORT | BLACK_SHORT)) ? 7 : 0);
+        return board.typeAt(rank + 4) == PieceType::KING && board.teamAt(rank + 4) == color
+            && board.typeAt(rook) == PieceType::ROOK && board.teamAt(rook) == color;
+    }
+}
+
+bool packPosition(const Position& position, PackedPosition& packed) {
+    packed = {};
+    const Board& board = position.board;
+    if (std::popcount(board.occupied()) > 32 || !playable(board))
+        return false;
+
+    packed.occupied = board.occupied();
+    Bitboard occupied = packed.occupied;
+    for (int i = 0; occupied; i++) {
+        int index = popSquare(occupied);
+        uint8_t code = board.teamAt(index) << 3 | static_cast<uint8_t>(board.typeAt(index));
+        packed.pieces[i / 2] |= (i & 1) ? code << 4 : code;
+    }
+
+    packed.fullmoveNumber = static_cast<uint16_t>(std::clamp(position.fullmoveNumber, 1, 0xffff));
+    packed.state = (position.toMove == Teams::BLACK) | position.castling << 1;
+    packed.enPassant = static_cast<int8_t>(position.enPassant);
+    packed.halfmoveClock = static_cast<uint8_t>(std::min(position.halfmoveClock, 255));
+    return true;
+}
+
+bool unpackPosition(const PackedPosition& packed, Position& position) {
+    position = Position();
+    if (std::popcount(packed.occupied) > 32 || packed.enPassant < -1 || (packed.state >> 5) != 0)
+        return false;
+
+    Bitboard occupied = packed.occupied;
+    for (int i = 0; occupied; i++) {
+        int index = popSquare(occupied);
+        uint8_t code = (packed.pieces[i / 2] >> ((i & 1) * 4)) & 15;
+        int type = code & 7;
+        if (type < static_cast<int>(PieceType::PAWN) || type > static_cast<int>(PieceType::KING))
+            return false;
+        position.board.PutPiece(index, static_cast<PieceType>(type), static_cast<Teams>(code >> 3));
+    }
+    if (!playable(position.board))
+        return false;
+
+    position.toMove = (packed.state & 1) ? Teams::BLACK : Teams::WHITE;
+    position.castling = packed.state >> 1;
+    for (int right : { WHITE_SHORT, WHITE_LONG, BLACK_SHORT, BLACK_LONG })
+        if ((position.castling & right) && !castlingPiecesInPlace(position.board, right))
+            return false;
+    // on the rank the last team to move's pawns skip
+    if (packed.enPassant != -1 && packed.enPassant >> 3 != (position.toMove == Teams::WHITE ? 5 : 2))
+        return false;
+    position.enPassant = packed.enPassant;
+    position.halfmoveClock = packed.halfmoveClock;
+    position.fullmoveNumber = std::max<int>(packed.fullmoveNumber, 1);
+    return true;
+}
+
+bool findPackedMove(const Game& game, uint16_t packed, CompleteMove& move) {
+    MoveList moves;
+    game.GenerateMoves(game.getToMove(), moves);
+    for (const auto& legal : moves) {
+        if (packMove(legal.move) == packed) {
+            move = legal;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BinaryWriter::Open(const std::string& path, RecordKind kind) {
+    Close();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+
+    this->kind = kind;
+    count = 0;
+    offsets.clear();
+
+    // filled in properly by Close()
+    FileHeader header = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    offset = sizeof(header);
+    return bool(file);
+}
+
+bool BinaryWriter::WritePosition(const Position& position) {
+    PackedPosition packed;
+    if (!packPosition(position, packed))
+        return false;
+    file.write(reinterpret_cast<const char*>(&packed), sizeof(packed));
+    offset += sizeof(packed);
+    count++;
+    return true;
+}
+
+bool BinaryWriter::WriteGame(const Position& start, const uint16_t* moves, uint32_t moveCount, GameResult result) {
+    GameHeader header = {};
+    if (!packPosition(start, header.start))
+        return false;
+    header.moveCount = moveCount;
+    header.result = result;
+
+    const char padding[8] = {};
+    uint64_t size = gameSize(moveCount);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(moves), moveCount * sizeof(uint16_t));
+    file.write(padding, size - sizeof(header) - moveCount * sizeof(uint16_t));
+
+    offsets.push_back(offset);
+    offset += size;
+    count++;
+    return true;
+}
+
+bool BinaryWriter::Close() {
+    if (!file.is_open())
+        return false;
+
+    FileHeader header = {};
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.kind = kind;
+    header.count = count;
+    if (kind == RecordKind::GAMES) {
+        header.index = offset;
+        file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    }
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    bool ok = bool(file);
+    file.close();
+    return ok;
+}
+
+bool BinaryReader::Open(const std::string& path) {
+    header = {};
+    data = nullptr;
+    offsets = nullptr;
+    if (!file.Open(path))
+        return false;
+
+    std::string_view text = file.text();
+    if (text.size() < sizeof(FileHeader))
+        return false;
+    memcpy(&header, text.data(), sizeof(header));
+    if (memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version) {
+        header = {};
+        return false;
+    }
+
+    // every record has to be inside the file
+    bool fits = false;
+    if (header.kind == RecordKind::POSITIONS)
+        fits = header.count <= (text.size() - sizeof(FileHeader)) / sizeof(PackedPosition);
+    else if (header.kind == RecordKind::GAMES && header.index % 8 == 0 && header.index <= text.size()
+        && header.count <= (text.size() - header.index) / sizeof(uint64_t)) {
+        offsets = reinterpret_cast<const uint64_t*>(text.data() + header.index);
+        fits = true;
+        for (size_t i = 0; i < header.count && fits; i++) {
+            uint64_t at = offsets[i];
+            fits = at % 8 == 0 && at >= sizeof(FileHeader) && at + sizeof(GameHeader) <= header.index
+                && at + gameSize(reinterpret_cast<const GameHeader*>(text.data() + at)->moveCount) <= header.index;
+        }
+    }
+    if (!fits) {
+        header = {};
+        offsets = nullptr;
+        return false;
+    }
+
+    data = text.data();
+    return true;
+}
+
+const PackedPosition& BinaryReader::position(size_t i) const {
+    return reinterpret_cast<const PackedPosition*>(data + sizeof(FileHeader))[i];
+}
+
+const GameHeader& BinaryReader::game(size_t i) const {
+    return *reinterpret_cast<const GameHeader*>(data + offsets[i]);
+}
+
+const uint16_t* BinaryReader::moves(size_t i) const {
+    return reinterpret_cast<const uint16_t*>(data + offsets[i] + sizeof(GameHeader));
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "Chess.h"
+#include "FEN.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// A binary file format for positions and games, so they can be loaded again without parsing any text.
+// Records are fixed size (or found through an index), so a reader maps the file and goes straight
+// to record i. Everything is stored little-endian, as the structs below are laid out on x86 and ARM.
+//
+// file:       FileHeader, then the records
+// positions:  PackedPosition[count]
+// games:      for every game a GameHeader followed by its moves (packMove(), 16 bits each, padded to 8 bytes),
+//             then uint64_t offsets[count] of every GameHeader (FileHeader::index says where)
+
+// a position in 32 bytes
+struct PackedPosition {
+    uint64_t occupied; // one bit per occupied square
+    // a nibble for every occupied square, lowest square first: team << 3 | PieceType
+    uint8_t pieces[16];
+    uint16_t fullmoveNumber;
+    uint8_t state; // bit 0: black to move, bits 1-4: CastlingRights
+    int8_t enPassant; // square index, -1 if none
+    uint8_t halfmoveClock; // (capped at 255)
+    uint8_t unused[3];
+};
+static_assert(sizeof(PackedPosition) == 32);
+
+// false if the position can't be stored: more than 32 pieces, not one king a team, or pawns on the back ranks
+// (unpackPosition() turns those down)
+bool packPosition(const Position& position, PackedPosition& packed);
+// false if the record doesn't hold a position (nothing in it is trusted, as it comes from a file)
+bool unpackPosition(const PackedPosition& packed, Position& position);
+
+enum class GameResult : uint8_t {
+    UNKNOWN,
+    WHITE_WINS,
+    BLACK_WINS,
+    DRAW,
+};
+
+struct GameHeader {
+    PackedPosition start;
+    uint32_t moveCount;
+    GameResult result;
+    uint8_t unused[3];
+};
+static_assert(sizeof(GameHeader) == 40);
+
+enum class RecordKind : uint32_t {
+    POSITIONS = 1,
+    GAMES = 2,
+};
+
+struct FileHeader {
+    char magic[8]; // "CHESSBIN"
+    uint32_t version;
+    RecordKind kind;
+    uint64_t count; // records
+    uint64_t index; // games: where the offsets are
+};
+static_assert(sizeof(FileHeader) == 32);
+
+// the legal move a packMove() stands for in the game, false if there isn't one
+bool findPackedMove(const Game& game, uint16_t packed, CompleteMove& move);
+
+// Writes a file of one kind of record. Nothing is valid until Close().
+class BinaryWriter {
+public:
+    ~BinaryWriter() { Close(); }
+
+    bool Open(const std::string& path, RecordKind kind);
+    // these write nothing and return false if the position can't be packed (see packPosition())
+    bool WritePosition(const Position& position);
+    bool WriteGame(const Position& start, const uint16_t* moves, uint32_t count, GameResult result);
+    // writes the games' index and the record count, returns whether everything made it to the file
+    bool Close();
+
+private:
+    std::ofstream file;
+    RecordKind kind = RecordKind::POSITIONS;
+    uint64_t count = 0;
+    uint64_t offset = 0; // where the next record goes
+    std::vector<uint64_t> offsets; // of every game, 8 bytes per game
+};
+
+// Maps a file written by BinaryWriter, and reads any record straight out of it
+class BinaryReader {
+public:
+    // false if the file can't be opened, or isn't one of ours
+    bool Open(const std::string& path);
+
+    RecordKind kind() const { return header.kind; }
+    size_t size() const { return header.count; }
+
+    const PackedPosition& position(size_t i) const;
+    const GameHeader& game(size_t i) const;
+    // the game's moves, GameHeader::moveCount of them
+    const uint16_t* moves(size_t i) const;
+
+private:
+    MappedFile file;
+    FileHeader header = {};
+    const char* data = nullptr;
+    const uint64_t* offsets = nullptr;
+};
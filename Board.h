@@ -0,0 +1,142 @@
+#pragma once
+#include "Piece.h"
+#include "Attacks.h"
+#include "Zobrist.h"
+#include "PieceSquareTables.h"
+#include <bit>
+#include <cstdint>
+
+// A set of squares, one bit per square.
+// Bit index is y * 8 + x, so a1 is bit 0 and h8 is bit 63.
+typedef uint64_t Bitboard;
+
+inline int squareIndex(const Square& square) { return square.y * 8 + square.x; }
+inline Square indexSquare(int index) { return { index & 7, index >> 3 }; }
+inline Bitboard squareBit(int index) { return Bitboard(1) << index; }
+
+// pops the lowest square off of a bitboard and returns its index
+inline int popSquare(Bitboard& bb) {
+    int index = std::countr_zero(bb);
+    bb &= bb - 1;
+    return index;
+}
+
+inline Teams opponent(Teams color) { return color == Teams::WHITE ? Teams::BLACK : Teams::WHITE; }
+
+// Castling rights, one bit per king & rook pair that hasn't moved
+enum CastlingRights {
+    WHITE_SHORT = 1,
+    WHITE_LONG = 2,
+    BLACK_SHORT = 4,
+    BLACK_LONG = 8,
+    ALL_CASTLES = 15,
+};
+
+inline int castlingRight(Teams color, CastleSide side) {
+    int right = side == CastleSide::SHORT ? WHITE_SHORT : WHITE_LONG;
+    return color == Teams::WHITE ? right : right << 2;
+}
+
+// The position of the pieces on an 8x8 board, for (at most) two teams.
+// Every query is a mask or array lookup, so nothing here hashes or allocates,
+// and copying a Board is just copying its arrays.
+class Board {
+public:
+    // one mask per piece type (indexed by PieceType, NONE is unused) and per colour
+    Bitboard pieces[7] = {};
+    Bitboard colors[2] = {};
+
+    // square index -> what stands on it
+    PieceType types[64] = {};
+
+    // Zobrist key of the pieces alone (see Zobrist.h), kept up to date as they move
+    uint64_t key = 0;
+
+    // the same, of the pawns alone (for the pawn structure cache, see PawnHashTable.h)
+    uint64_t pawnKey = 0;
+
+    // piece-square sums by team (see PieceSquareTables.h) and the game phase, also kept up to date
+    int middlegame[2] = {};
+    int endgame[2] = {};
+    int phase = 0;
+
+    void PutPiece(int index, PieceType type, Teams color) {
+        pieces[static_cast<int>(type)] |= squareBit(index);
+        colors[color] |= squareBit(index);
+        types[index] = type;
+        key ^= zobrist.pieces[color][static_cast<int>(type)][index];
+        if (type == PieceType::PAWN)
+            pawnKey ^= zobrist.pieces[color][static_cast<int>(type)][index];
+        middlegame[color] += pieceSquare.middlegame[color][static_cast<int>(type)][index];
+        endgame[color] += pieceSquare.endgame[color][static_cast<int>(type)][index];
+        phase += phaseWeights[static_cast<int>(type)];
+    }
+
+    // takes a piece off the board and returns what it was
+    PieceType RemovePiece(int index) {
+        PieceType type = types[index];
+        if (type != PieceType::NONE) {
+            Teams color = teamAt(index);
+            key ^= zobrist.pieces[color][static_cast<int>(type)][index];
+            if (type == PieceType::PAWN)
+                pawnKey ^= zobrist.pieces[color][static_cast<int>(type)][index];
+            middlegame[color] -= pieceSquare.middlegame[color][static_cast<int>(type)][index];
+            endgame[color] -= pieceSquare.endgame[color][static_cast<int>(type)][index];
+            phase -= phaseWeights[static_cast<int>(type)];
+        }
+        pieces[static_cast<int>(type)] &= ~squareBit(index);
+        colors[0] &= ~squareBit(index);
+        colors[1] &= ~squareBit(index);
+        types[index] = PieceType::NONE;
+        return type;
+    }
+
+    // moves a piece onto an empty square
+    void MovePiece(int from, int to) {
+        Teams color = teamAt(from);
+        PutPiece(to, RemovePiece(from), color);
+    }
+
+    PieceType typeAt(int index) const { return types[index]; }
+    Teams teamAt(int index) const {
+        if (colors[0] & squareBit(index)) return Teams::WHITE;
+        if (colors[1] & squareBit(index)) return Teams::BLACK;
+        return Teams::NONE;
+    }
+
+    Bitboard occupied() const { return colors[0] | colors[1]; }
+    Bitboard piecesOf(Teams color, PieceType type) const {
+        return colors[color] & pieces[static_cast<int>(type)];
+    }
+
+    // the team's pieces of one type that attack a square
+    // (pawns by capturing, a pawn that would move there without capturing isn't attacking it)
+    Bitboard attackersOf(int index, PieceType type, Teams by) const {
+        Bitboard occupied = this->occupied();
+        Bitboard reach = 0;
+        switch (type) {
+            case PieceType::PAWN: reach = attacks.pawn[opponent(by)][index]; break;
+            case PieceType::KNIGHT: reach = attacks.knight[index]; break;
+            case PieceType::BISHOP: reach = bishopAttacks(index, occupied); break;
+            case PieceType::ROOK: reach = rookAttacks(index, occupied); break;
+            case PieceType::QUEEN: reach = queenAttacks(index, occupied); break;
+            case PieceType::KING: reach = attacks.king[index]; break;
+            default: break;
+        }
+        return reach & piecesOf(by, type);
+    }
+
+    // whether any of the team's pieces attack a square
+    bool isAttacked(int index, Teams by) const {
+        Bitboard occupied = this->occupied();
+        Bitboard diagonal = piecesOf(by, PieceType::BISHOP) | piecesOf(by, PieceType::QUEEN);
+        Bitboard straight = piecesOf(by, PieceType::ROOK) | piecesOf(by, PieceType::QUEEN);
+
+        // pawns attack the squares an enemy pawn standing here would capture on
+        return (attacks.pawn[opponent(by)][index] & piecesOf(by, PieceType::PAWN))
+            || (attacks.knight[index] & piecesOf(by, PieceType::KNIGHT))
+            || (attacks.king[index] & piecesOf(by, PieceType::KING))
+            || (bishopAttacks(index, occupied) & diagonal)
+            || (rookAttacks(index, occupied) & straight);
+    }
+};
@@ -1,72 +1,154 @@
 #include "Chess.h"
+#include "Diagnostics.h"
+#include <cstring>
 
-Game::Game(std::vector<PieceMap> teams) : teams(teams) {
+Piece* sharedPiece(const PieceType type, const Teams color) {
+    static Pawn pawns[2] = { Pawn(pawnDirection(Teams::WHITE)), Pawn(pawnDirection(Teams::BLACK)) };
+    static Knight knight;
+    static Bishop bishop;
+    static Rook rook;
+    static Queen queen;
+    static King king;
+
+    switch (type) {
+        case PieceType::PAWN: return &pawns[color == Teams::BLACK];
+        case PieceType::KNIGHT: return &knight;
+        case PieceType::BISHOP: return &bishop;
+        case PieceType::ROOK: return &rook;
+        case PieceType::QUEEN: return &queen;
+        case PieceType::KING: return &king;
+        default: return nullptr;
+    }
+}
+
+Game::Game(std::vector<PieceMap> teams, Teams toMove, std::pmr::memory_resource* arena)
+    : teamCount(teams.size()), toMove(toMove), undoStack(arena ? arena : std::pmr::get_default_resource()) {
     // initialization logic
 
-    positionHistory.reserve(100);
-    for (const auto& team : teams) for (const auto& pair : team) {
+    undoStack.reserve(256);
+    for (int i = 0; i < teamCount; i++) for (const auto& pair : teams[i]) {
         Square square = pair.first;
         Piece* piece = pair.second;
 
-        if (!inBounds(pair.first))
+        if (piece == nullptr)
             continue;
 
-        switch (piece->Type()) {
-            case PieceType::PAWN:
-                if (square.y != 1 && square.y != 6)
-                    moved.push_back(piece);
-                break;
-            case PieceType::ROOK:
-                if (square.y != 0 && square.y != 8)
-                    moved.push_back(piece);
-                break;
-        }
+        // the board only has room for two teams on 8x8 squares
+        if (inBounds(square) && i <= Teams::BLACK)
+            board.PutPiece(squareIndex(square), piece->Type(), static_cast<Teams>(i));
     }
 
-    UpdateHistory();
+    guessCastling();
 }
 
 // Initialize a game without pieces
-Game::Game(int teamcount) { 
-    teams.reserve(teamcount); 
-    positionHistory.reserve(100);
+Game::Game(int teamcount, std::pmr::memory_resource* arena)
+    : teamCount(teamcount), undoStack(arena ? arena : std::pmr::get_default_resource()) { 
+    undoStack.reserve(256);
+}
+
+bool Game::Load(std::string_view fen) {
+    FENError error;
+    return Load(fen, error);
+}
+
+bool Game::Load(std::string_view fen, FENError& error) {
+    Position position;
+    if (!parseFEN(fen, position, error))
+        return false;
+    SetPosition(position);
+    return true;
+}
+
+bool Game::LoadEPD(std::string_view epd, FENError& error, size_t& operations) {
+    Position position;
+    if (!parseEPD(epd, position, error, operations))
+        return false;
+    SetPosition(position);
+    return true;
 }
 
-// Dynamically delete certain member data
-Game::~Game() {
-    // delete piecemap pieces
-    for (const auto& team : teams) for (const auto& pair : team)
-    delete pair.second;
+void Game::SetPosition(const Position& position) {
+    board = position.board;
+    toMove = position.toMove;
+    castling = position.castling;
+    enPassant = position.enPassant;
+    lastReversableMove = position.halfmoveClock;
+    pliesBefore = 2 * (position.fullmoveNumber - 1) + (toMove == Teams::BLACK);
+    lastMove = CompleteMove();
+    undoStack.clear();
+}
 
-    // delete moved pieces
-    for (const Piece* piece : moved)
-    delete piece;
+Position Game::getPosition() const {
+    Position position;
+    position.board = board;
+    position.toMove = toMove;
+    position.castling = castling;
+    position.enPassant = enPassant;
+    position.halfmoveClock = lastReversableMove;
+    position.fullmoveNumber = 1 + (pliesBefore + static_cast<int>(undoStack.size())) / 2;
+    return position;
+}
+
+std::string Game::ToFEN() const {
+    char fen[MAX_FEN_LENGTH + 1];
+    return std::string(fen, writeFEN(getPosition(), fen));
+}
+
+// a king & rook still on their starting squares are assumed to not have moved
+void Game::guessCastling() {
+    for (int i = Teams::WHITE; i <= Teams::BLACK; i++) {
+        Teams color = static_cast<Teams>(i);
+        int homeRank = (color == Teams::WHITE) ? 0 : 7;
+        if (getPieceType({ 4, homeRank }) != PieceType::KING || getPieceTeam({ 4, homeRank }) != color)
+            continue;
+
+        for (int rookX = 0; rookX <= 7; rookX += 7) {
+            if (getPieceType({ rookX, homeRank }) == PieceType::ROOK && getPieceTeam({ rookX, homeRank }) == color)
+                castling |= castlingRight(color, rookX == 7 ? CastleSide::SHORT : CastleSide::LONG);
+        }
+    }
+}
+
+// Whether a generated legal move is the one a (possibly partial) move asks for
+static bool matchesMove(const CompleteMove& legal, const CompleteMove& asked) {
+    if (legal.move.from != asked.move.from || legal.move.to != asked.move.to)
+        return false;
+
+    if (asked.pieceType != PieceType::NONE && asked.pieceType != legal.pieceType)
+        return false;
+
+    // default to queen for promoting
+    PieceType promotion = asked.move.promotion;
+    if (promotion == PieceType::NONE && legal.move.promotion != PieceType::NONE)
+        promotion = PieceType::QUEEN;
+    return legal.move.promotion == promotion;
 }
 
 // Checks a Move's Legality and then performs the move, returns its success.
 bool Game::AttemptMoves(const std::vector<CompleteMove>& possibleMoves, int color) {
 
-    // discover which moves are legal
-    std::vector<CompleteMove> legalMoves;
-    for (auto pm : possibleMoves) {
-        CompleteMove legal = LegalMove(pm);
-        if (legal.valid && legal == pm)
-            legalMoves.push_back(legal);
+    // discover which moves are legal, all in one generation pass
+    const MoveList& moves = legalMoves(static_cast<Teams>(color));
+
+    std::vector<CompleteMove> matches;
+    for (const auto& pm : possibleMoves) {
+        for (const auto& legal : moves) {
+            if (matchesMove(legal, pm))
+                matches.push_back(legal);
+        }
     }
 
     // If the player has entered it properly, there should only be one legal move
-    if (legalMoves.size() == 1) {
-        AttemptMove(legalMoves[0]);
+    if (matches.size() == 1) {
+        MakeMove(matches[0]);
         return true;
     }
 
     // Report improper move interpretation
-    std::cerr << "There are " << legalMoves.size()
-        << " legal moves" << std::endl;
-    for (auto move : legalMoves) {
-        std::cerr << "Move 1: " << static_cast<int>(move.pieceType) << " " << move.move.from.x << " " << move.move.from.y 
-            << ": " << move.move.to.x << " " << move.move.to.y << std::endl;
-    }
+    CHESS_DIAG(DiagLevel::INFO, DiagCategory::INPUT, "there are " << matches.size() << " legal moves");
+    for (const auto& move : matches)
+        CHESS_DIAG(DiagLevel::INFO, DiagCategory::INPUT, "  " << moveName(move));
     return false;
 }
 
@@ -77,43 +159,58 @@ bool Game::AttemptMove(const CompleteMove& move) {
         return false;
 
     // the move must be precise
-    if (move != LegalMove(move.move, move.color, move.pieceType))
-        return false;
-
-    // perform actual move
-    if (move.moveType.castles) {
+    for (const auto& legal : legalMoves(move.color)) {
+        if (matchesMove(legal, move)) {
+            MakeMove(legal);
+            return true;
+        }
+    }
+    return false;
+}
 
-        // castles are technically two 'moves'
-        if (move.moveType.castleDir) {
-            MovePiece({ move.move.from, { 6, move.move.from.y }}, move.color); // move king
-            MovePiece({ { 7, move.move.from.y }, { 5, move.move.from.y }}, move.color); // move rook
-        } else {
-            MovePiece({ move.move.from, { 2, move.move.from.y }}, move.color); // move king
-            MovePiece({ { 0, move.move.from.y }, { 3, move.move.from.y }}, move.color); // move rook
+namespace {
+    // castling rights that are lost when anything moves from or to a square
+    int castlingLost(int index) {
+        switch (index) {
+            case 0: return WHITE_LONG;
+            case 4: return WHITE_SHORT | WHITE_LONG;
+            case 7: return WHITE_SHORT;
+            case 56: return BLACK_LONG;
+            case 60: return BLACK_SHORT | BLACK_LONG;
+            case 63: return BLACK_SHORT;
+            default: return 0;
         }
+    }
 
-    } else {
-        MovePiece(move.move, move.color);
+    // where the king and rook land when castling
+    int castleKingTo(const CompleteMove& move) { return squareIndex({ move.moveType.castleSide == CastleSide::SHORT ? 6 : 2, move.move.from.y }); }
+    int castleRookTo(const CompleteMove& move) { return squareIndex({ move.moveType.castleSide == CastleSide::SHORT ? 5 : 3, move.move.from.y }); }
 
-        // fake 'capture' edge case for en passant
+    // the square of the piece a move captures (en passant captures beside the destination)
+    int capturedSquare(const CompleteMove& move) {
         if (move.moveType.enPassant)
-            DeletePiece(lastMove.move.to);   
+            return squareIndex({ move.move.to.x, move.move.from.y });
+        return squareIndex(move.move.to);
     }
 
-    // perform promotions
-    if (move.move.promotion != PieceType::NONE)
-        PromotePiece(move.move, move.color, move.move.promotion);
+    // whether the mover's king is safe once the move is played (on a scratch copy of the board)
+    bool kingSafeAfter(const Board& board, const CompleteMove& move) {
+        Board after = board;
+        int from = squareIndex(move.move.from);
+        int to = squareIndex(move.move.to);
 
-    // game status updates
- 
-    // update for the fifty-move rule
-    lastReversableMove++;
-    if (move.moveType.captures || move.pieceType == PieceType::PAWN)
-        lastReversableMove = 0;
+        if (move.moveType.castles) {
+            after.MovePiece(from, castleKingTo(move));
+            after.MovePiece(to, castleRookTo(move));
+        } else {
+            if (move.moveType.captures)
+                after.RemovePiece(capturedSquare(move));
+            after.MovePiece(from, to);
+        }
 
-    UpdateHistory();
-    lastMove = move;
-    return true;
+        Bitboard king = after.piecesOf(move.color, PieceType::KING);
+        return !king || !after.isAttacked(std::countr_zero(king), opponent(move.color));
+    }
 }
 
 bool Game::AttemptMove(const Move& move, const Teams color, const PieceType pieceType) 
@@ -123,15 +220,27 @@ bool Game::AttemptMove(const Move& move, const Teams color, const PieceType piec
 // Constant member functions
 //
 
+// LegalMove()'s way out, the move stays invalid
+static CompleteMove rejected(CompleteMove move, Rejection reason) {
+    move.rejection = reason;
+    return move;
+}
+
 // Validates whether a move is legal in the context of the game
-CompleteMove Game::LegalMove(const CompleteMove& m) const 
-{ return LegalMove(m.move, m.color, m.pieceType); }
+// (counted, timed and its depth kept track of by the Move overload)
+CompleteMove Game::LegalMove(const CompleteMove& m) const {
+    return LegalMove(m.move, m.color, m.pieceType);
+}
 
 // This function also builds / infers a Complete, Legal move from a partial move 
 // This functionality is useful in the AttemptMove(CompleteMove) function, because it maintains that a full move must be precise in order to prevent unintended moves by a user
 // **This is the main role of the Game class, it would have been divided further if we had time left for organization, that is why it is huge.**
 // **the other main role is getWinner(), which is compartimentalized better**
-CompleteMove Game::LegalMove(const Move& m, const Teams color, const PieceType pieceType, const Move& pretendMove) const {
+CompleteMove Game::LegalMove(const Move& m, const Teams color, const PieceType pieceType) const {
+    CHESS_COUNT(LEGAL_MOVE);
+    CHESS_LEGAL_MOVE_DEPTH();
+    CHESS_TIME(LEGAL_MOVE);
+
     // Invariant:
     // there must be only one Legal CompleteMove for every valid move
 
@@ -144,28 +253,18 @@ CompleteMove Game::LegalMove(const Move& m, const Teams color, const PieceType p
     legal.valid = false; 
 
     if (!inBounds(legal.move.to))
-        return legal;
+        return rejected(legal, Rejection::OFF_BOARD);
 
     // check if it's the right color
     if (getPieceTeam(legal.move.from) != color) {
-        return legal;
+        return rejected(legal, Rejection::WRONG_TEAM);
     } else 
     legal.color = color;
 
     // Begin filling in the rest of the move data
 
-    Piece* captured;
-    Square capturedSquare;
-
-    // detect if capturing the pretend move
-    if ((pretendMove.from != pretendMove.to) && (pretendMove.to == legal.move.to))
-        capturedSquare = pretendMove.from;
-    else
-        capturedSquare = legal.move.to;
-    captured = getPiece(capturedSquare);
-    legal.moveType.captures = (captured != nullptr);
-
-    Piece* piece;
+    Square capturedSquare = legal.move.to;
+    legal.moveType.captures = (getPiece(capturedSquare) != nullptr);
 
     // There are two types of castle moves:
     // - one is a move where the king tries to capture its own rook
@@ -176,37 +275,26 @@ CompleteMove Game::LegalMove(const Move& m, const Teams color, const PieceType p
         legal.move.from = getKing(color);
         legal.pieceType = PieceType::KING;
         legal.move.to = legal.move.from;
-        if (legal.moveType.castleDir)
-            legal.move.to.x = 0;
-        else
-            legal.move.to.x = 7;
+        // (short when it doesn't say)
+        legal.move.to.x = legal.moveType.castleSide == CastleSide::LONG ? 0 : 7;
     }
 
-    // now we can define the piece ptr, since legal.move.from has been built
-    piece = getPiece(legal.move.from);
-
     // determine if user is trying to castle by 'capturing' its own rook
     if (legal.color == getPieceTeam(capturedSquare)) { 
-        if (legal.pieceType == PieceType::KING && getPieceType(capturedSquare) == PieceType::ROOK) {
+        if (legal.pieceType == PieceType::KING && getPieceType(capturedSquare) == PieceType::ROOK
+            && legal.move.to.y == legal.move.from.y && (legal.move.to.x == 0 || legal.move.to.x == 7)) {
             legal.moveType.castles = true;
-            legal.moveType.castleDir = legal.move.to.x == 7;
+            legal.moveType.castleSide = legal.move.to.x == 7 ? CastleSide::SHORT : CastleSide::LONG;
+            legal.moveType.captures = false;
         }
 
         // you can't normally capture your own piece...
         if (!legal.moveType.castles)
-            return legal;
+            return rejected(legal, Rejection::OWN_PIECE);
 
         // qualify that a castle requires the king and rook to not have moved
-        for (auto movedPiece : moved) {
-            if (movedPiece == piece) {
-                // std::cerr << "king has already moved, cannot castle" << std::endl;
-                return legal;
-            }
-            if (movedPiece == captured) {
-                // std::cerr << "that rook has already moved, cannot castle" << std::endl;
-                return legal;
-            }
-        }
+        if (!(castling & castlingRight(color, legal.moveType.castleSide)) || legal.move.from.x != 4)
+            return rejected(legal, Rejection::NO_CASTLING_RIGHT);
     }
 
     // ensure correct piece type
@@ -216,136 +304,317 @@ CompleteMove Game::LegalMove(const Move& m, const Teams color, const PieceType p
         legal.pieceType = PieceType::KING;  // Set to KING for castling
     } else {
         if (getPieceType(legal.move.from) != legal.pieceType)
-            return legal;
+            return rejected(legal, Rejection::WRONG_PIECE);
     }
 
     if (legal.move.promotion != PieceType::NONE && legal.pieceType != PieceType::PAWN)
-        return legal;
+        return rejected(legal, Rejection::BAD_PROMOTION);
 
     // ensure move is possible via piece definition
-    if (!legal.moveType.castles && !piece->PossibleMove(m))
-        return legal;
-
-    // in the scenario that you're being captured, you cannot move
-    if (pretendMove.from != pretendMove.to && pretendMove.to == legal.move.from)
-        return legal;
+    if (!legal.moveType.castles && !possibleMove(legal.pieceType, m, pawnDirection(color)))
+        return rejected(legal, Rejection::IMPOSSIBLE);
 
     Square offset = (legal.move.to - legal.move.from);
     switch (legal.pieceType) {
         case PieceType::PAWN:
 
             // detect en passant
-            if (lastMove.pieceType == PieceType::PAWN && abs(lastMove.move.from.y - lastMove.move.to.y) > 1) {
-                if (legal.move.to.x == lastMove.move.from.x && legal.move.to.y + offset.y == lastMove.move.from.y) {
-                    legal.moveType.enPassant = true;
-                    legal.moveType.captures = true;
-                }
+            if (squareIndex(legal.move.to) == enPassant && offset.x != 0 && legal.move.to.y == (color == Teams::WHITE ? 5 : 2)) {
+                legal.moveType.enPassant = true;
+                legal.moveType.captures = true;
             }
 
             // a pawn captures if and only if it moves sideways
             if (legal.moveType.captures != (offset.x != 0))
-                return legal;
+                return rejected(legal, Rejection::PAWN_CAPTURE);
 
-            if (abs(offset.y) >= 2) {
-                for (auto movedPiece : moved) {
-                    if (movedPiece == piece)
-                        return legal;
-                }
-            }
+            // only unmoved pawns (still on their starting rank) can double step
+            if (abs(offset.y) >= 2 && legal.move.from.y != (color == Teams::WHITE ? 1 : 6))
+                return rejected(legal, Rejection::PAWN_DOUBLE_STEP);
 
             if (legal.move.to.y == 7 || legal.move.to.y == 0) {
                 // default to queen for promoting
                 if (legal.move.promotion == PieceType::NONE)
                     legal.move.promotion = PieceType::QUEEN;
+                legal.moveType.promotes = true;
             }               
 
             break;
         case PieceType::KING:
             if (abs(offset.x) > 1 || abs(offset.y) > 1) {
                 if (!legal.moveType.castles)
-                    return legal;
+                    return rejected(legal, Rejection::IMPOSSIBLE);
             }
 
+            break;
+        default:
             break;
     }
 
     // ... check if piece collides with something on the way
-    if (legal.pieceType != PieceType::KNIGHT) {
-        // knights can jump over pieces
+    // (the piece definition already checked the shape of the move, knights can jump over pieces)
+    Bitboard occupied = board.occupied();
+    int from = squareIndex(legal.move.from);
+    Bitboard to = squareBit(squareIndex(legal.move.to));
+    switch (legal.pieceType) {
+        case PieceType::PAWN:
+            if (abs(offset.y) >= 2 && (occupied & squareBit(squareIndex(legal.move.from + offset.normalized()))))
+                return rejected(legal, Rejection::BLOCKED);
+            break;
+        case PieceType::BISHOP:
+            if (!(bishopAttacks(from, occupied) & to))
+                return rejected(legal, Rejection::BLOCKED);
+            break;
+        case PieceType::ROOK:
+            if (!(rookAttacks(from, occupied) & to))
+                return rejected(legal, Rejection::BLOCKED);
+            break;
+        case PieceType::KING:
+            // a castling king 'captures' its rook along the rank
+            if (legal.moveType.castles && !(rookAttacks(from, occupied) & to))
+                return rejected(legal, Rejection::BLOCKED);
+            break;
+        case PieceType::QUEEN:
+            if (!(queenAttacks(from, occupied) & to))
+                return rejected(legal, Rejection::BLOCKED);
+            break;
+        default:
+            break;
+    }
 
-        Square step = offset.normalized();
-        Square scan = legal.move.from;
+    // ensure that it's not moving into check
+    Teams enemy = opponent(color);
+    if (legal.moveType.castles) {
+        // the king can't castle out of, or through, check either
+        Square through = legal.move.from + Square{ legal.moveType.castleSide == CastleSide::SHORT ? 1 : -1, 0 };
+        if (isSquareAttacked(legal.move.from, enemy) || isSquareAttacked(through, enemy)) {
+            CHESS_DIAG(DiagLevel::INFO, DiagCategory::LEGALITY, "cannot castle out of, or through, check: " << moveName(legal));
+            return rejected(legal, Rejection::CASTLING_THROUGH_CHECK);
+        }
+    }
 
-        while (true) {
-            scan += step;
-            if (scan == legal.move.to)
-                break;
+    if (!kingSafeAfter(board, legal)) {
+        CHESS_DIAG(DiagLevel::INFO, DiagCategory::LEGALITY, "would leave the king in check: " << moveName(legal));
+        return rejected(legal, Rejection::SELF_CHECK);
+    }
 
-            if (scan == pretendMove.to)
-                return legal;
+    legal.valid = true;
+    return legal;
+}
 
-            if (scan == pretendMove.from)
-                continue;
+//
+// Move generation
+//
+
+namespace {
+    const PieceType promotions[4] = { PieceType::QUEEN, PieceType::ROOK, PieceType::BISHOP, PieceType::KNIGHT };
+
+    const Bitboard fileA = 0x0101010101010101;
+    const Bitboard fileH = fileA << 7;
+
+    // every bit one rank towards the other side of the board
+    template <Teams Us>
+    Bitboard forwardOf(Bitboard bb) { return Us == Teams::WHITE ? bb << 8 : bb >> 8; }
+
+    // one CompleteMove per square in targets, all from the same square
+    void addMoves(MoveList& moves, const CompleteMove& move, Bitboard targets, Bitboard enemies) {
+        while (targets) {
+            int to = popSquare(targets);
+            CompleteMove target = move;
+            target.move.to = indexSquare(to);
+            target.moveType.captures = (enemies & squareBit(to)) != 0;
+            moves.push(target);
+        }
+    }
 
-            if (getPiece(scan) == nullptr)
+    // pawn moves landing on targets, coming from delta squares back
+    void addPawnMoves(MoveList& moves, Teams color, Bitboard targets, int delta, bool captures, Bitboard promotionRank) {
+        while (targets) {
+            int to = popSquare(targets);
+            CompleteMove move;
+            move.valid = true;
+            move.color = color;
+            move.pieceType = PieceType::PAWN;
+            move.move.from = indexSquare(to - delta);
+            move.move.to = indexSquare(to);
+            move.moveType.captures = captures;
+
+            if (!(promotionRank & squareBit(to))) {
+                moves.push(move);
                 continue;
+            }
+            move.moveType.promotes = true;
+            for (PieceType promotion : promotions) {
+                move.move.promotion = promotion;
+                moves.push(move);
+            }
+        }
+    }
+
+    template <Teams Us, PieceType Type>
+    void addPieceMoves(const Board& board, MoveList& moves) {
+        Bitboard occupied = board.occupied();
+        Bitboard enemies = board.colors[opponent(Us)];
+        Bitboard pieces = board.piecesOf(Us, Type);
+        while (pieces) {
+            int index = popSquare(pieces);
+            CompleteMove move;
+            move.valid = true;
+            move.color = Us;
+            move.pieceType = Type;
+            move.move.from = indexSquare(index);
+            addMoves(moves, move, pieceTargets<Type>(index, occupied) & ~board.colors[Us], enemies);
+        }
+    }
+}
 
-            return legal;
+// Everything about the team to move is known at compile time here, so the
+// directions, ranks and piece rules are all constants the compiler can fold in.
+template <Teams Us>
+void Game::generateMoves(MoveList& moves) const {
+    constexpr Teams Them = Us == Teams::WHITE ? Teams::BLACK : Teams::WHITE;
+    constexpr int forward = Us == Teams::WHITE ? 8 : -8;
+    constexpr int homeRank = Us == Teams::WHITE ? 0 : 7;
+    constexpr Bitboard thirdRank = Us == Teams::WHITE ? 0xff0000 : 0xff0000000000;
+    constexpr Bitboard lastRank = Us == Teams::WHITE ? 0xff00000000000000 : 0xff;
+
+    Bitboard occupied = board.occupied();
+    Bitboard enemies = board.colors[Them];
+
+    // first every pseudo-legal move, pawns a whole rank at a time...
+    Bitboard pawns = board.piecesOf(Us, PieceType::PAWN);
+    Bitboard single = forwardOf<Us>(pawns) & ~occupied;
+    Bitboard twice = forwardOf<Us>(single & thirdRank) & ~occupied;
+    // seen from white, towards the a and h files
+    Bitboard left = forwardOf<Us>(pawns & ~fileA) >> 1;
+    Bitboard right = forwardOf<Us>(pawns & ~fileH) << 1;
+    addPawnMoves(moves, Us, single, forward, false, lastRank);
+    addPawnMoves(moves, Us, twice, 2 * forward, false, lastRank);
+    addPawnMoves(moves, Us, left & enemies, forward - 1, true, lastRank);
+    addPawnMoves(moves, Us, right & enemies, forward + 1, true, lastRank);
+
+    // en passant captures the pawn that just double stepped past
+    if (enPassant >= 0 && indexSquare(enPassant).y == homeRank + (Us == Teams::WHITE ? 5 : -5)) {
+        Bitboard capturers = attacks.pawn[Them][enPassant] & pawns;
+        while (capturers) {
+            CompleteMove capture;
+            capture.valid = true;
+            capture.color = Us;
+            capture.pieceType = PieceType::PAWN;
+            capture.move.from = indexSquare(popSquare(capturers));
+            capture.move.to = indexSquare(enPassant);
+            capture.moveType.captures = true;
+            capture.moveType.enPassant = true;
+            moves.push(capture);
         }
     }
 
-    // ensure that it's not moving into check
-    if (pretendMove.from == pretendMove.to) {
-        // reached if it is the first iteration
-
-        Square king;
-        if (legal.pieceType == PieceType::KING) {
-            king = legal.move.to;
-            if (legal.moveType.castles) {
-                if (legal.moveType.castleDir)
-                    king.x = 6;
-                else
-                    king.x = 2;
-            } 
-        } else 
-        king = getKing(color);
-
-        for (int i = 0; i < teams.size(); i++) {
-            if (static_cast<Teams>(i) == color)
+    // ...then the pieces, one type at a time
+    addPieceMoves<Us, PieceType::KNIGHT>(board, moves);
+    addPieceMoves<Us, PieceType::BISHOP>(board, moves);
+    addPieceMoves<Us, PieceType::ROOK>(board, moves);
+    addPieceMoves<Us, PieceType::QUEEN>(board, moves);
+    addPieceMoves<Us, PieceType::KING>(board, moves);
+
+    // castles are the king 'capturing' its own unmoved rook
+    constexpr int kingHome = homeRank * 8 + 4;
+    if ((castling & (castlingRight(Us, CastleSide::SHORT) | castlingRight(Us, CastleSide::LONG)))
+        && (board.piecesOf(Us, PieceType::KING) & squareBit(kingHome)) && !board.isAttacked(kingHome, Them)) {
+        for (int rookX = 0; rookX <= 7; rookX += 7) {
+            int rookIndex = homeRank * 8 + rookX;
+            if (!(castling & castlingRight(Us, rookX == 7 ? CastleSide::SHORT : CastleSide::LONG)))
+                continue;
+            if (!(board.piecesOf(Us, PieceType::ROOK) & squareBit(rookIndex)))
                 continue;
 
-            // TODO still no clue why this calls twice, doesn't effect it though
-            // std::cout << "Checking team " << i << " for possible checks" << std::endl;
-
-            for (const auto& pair : teams[i]) {
-                Square square = pair.first;
-                if (pair.second == nullptr) {
-                    std::cerr << "dead square: " << pair.first.x << pair.first.y << std::endl;
-                    continue;
-                }
-
-                if (legal.moveType.castles) {
-                    if (LegalMove({square, legal.move.from}, static_cast<Teams>(i), getPieceType(square), { {-1, -1}, {-2, -2} }).valid) {
-                        std::cerr << "Cannot castle out of check!" << std::endl;
-                        return legal;
-                    }
-
-                    if (legal.moveType.castleDir) king.x = 6;
-                    else king.x = 2;
-                } 
-
-                if (LegalMove({square, king}, static_cast<Teams>(i), getPieceType(square), m).valid) {
-                    std::cerr << "You would be putting yourself in check!" << std::endl;
-                    std::cerr << "Attacking piece location: " << square.x << " " << square.y 
-                        << std::endl;
-                    return legal;
-                }
-            }
+            // everything between the king and rook must be empty
+            if (!(rookAttacks(kingHome, occupied) & squareBit(rookIndex)))
+                continue;
+
+            // the king cannot pass through check (landing in check is filtered below)
+            if (board.isAttacked(kingHome + (rookX == 7 ? 1 : -1), Them))
+                continue;
+
+            CompleteMove castle;
+            castle.valid = true;
+            castle.color = Us;
+            castle.pieceType = PieceType::KING;
+            castle.move.from = indexSquare(kingHome);
+            castle.move.to = indexSquare(rookIndex);
+            castle.moveType.castles = true;
+            castle.moveType.castleSide = rookX == 7 ? CastleSide::SHORT : CastleSide::LONG;
+            moves.push(castle);
         }
     }
 
-    legal.valid = true;
-    return legal;
+    // and keep the ones that don't leave the king in check.
+    // Out of check, only king moves, en passant and pinned pieces can do that, the rest are kept without trying them.
+    Bitboard king = board.piecesOf(Us, PieceType::KING);
+    Bitboard risky = ~Bitboard(0);
+    if (king && !board.isAttacked(std::countr_zero(king), Them))
+        risky = king | pinnedPieces<Us>(std::countr_zero(king));
+
+    int legalCount = 0;
+    for (int i = 0; i < moves.size(); i++) {
+        const CompleteMove& move = moves[i];
+        bool safe = !(risky & squareBit(squareIndex(move.move.from))) && !move.moveType.enPassant;
+        if (safe || kingSafeAfter(board, move))
+            moves[legalCount++] = move;
+    }
+    moves.count = legalCount;
+}
+
+// own pieces standing between the king and an enemy slider, which can't step off that line
+template <Teams Us>
+Bitboard Game::pinnedPieces(int king) const {
+    constexpr Teams Them = Us == Teams::WHITE ? Teams::BLACK : Teams::WHITE;
+    Bitboard occupied = board.occupied();
+    Bitboard queens = board.piecesOf(Them, PieceType::QUEEN);
+    Bitboard straight = board.piecesOf(Them, PieceType::ROOK) | queens;
+    Bitboard diagonal = board.piecesOf(Them, PieceType::BISHOP) | queens;
+
+    Bitboard pinned = 0;
+    for (int direction = NORTH; direction <= SOUTH_EAST; direction++) {
+        Bitboard sliders = (direction == NORTH || direction == EAST || direction == SOUTH || direction == WEST) ? straight : diagonal;
+        if (!(attacks.rays[direction][king] & sliders))
+            continue;
+
+        // the first piece from the king is ours, and the next one an enemy slider
+        Bitboard first = rayAttacks(static_cast<Direction>(direction), king, occupied) & occupied;
+        if (!(first & board.colors[Us]))
+            continue;
+        Bitboard second = rayAttacks(static_cast<Direction>(direction), std::countr_zero(first), occupied) & occupied;
+        if (second & sliders)
+            pinned |= first;
+    }
+    return pinned;
+}
+
+void Game::GenerateMoves(const Teams color, MoveList& moves) const {
+    CHESS_COUNT(GENERATE_MOVES);
+    CHESS_TIME(GENERATE_MOVES);
+    moves.clear();
+    if (color == Teams::WHITE)
+        generateMoves<Teams::WHITE>(moves);
+    else if (color == Teams::BLACK)
+        generateMoves<Teams::BLACK>(moves);
+}
+
+const MoveList& Game::legalMoves(const Teams color) const {
+    // nobody else has moves
+    static const MoveList none;
+    if (color != Teams::WHITE && color != Teams::BLACK)
+        return none;
+
+    uint64_t key = getKey();
+    if (const MoveList* cached = moveCache.find(color, key)) {
+        CHESS_COUNT(MOVE_CACHE_HIT);
+        return *cached;
+    }
+    CHESS_COUNT(MOVE_CACHE_MISS);
+    MoveList& moves = moveCache.slot(color, key);
+    GenerateMoves(color, moves);
+    return moves;
 }
 
 //
@@ -354,84 +623,57 @@ CompleteMove Game::LegalMove(const Move& m, const Teams color, const PieceType p
 
 Teams Game::getWinner() const {
 
-    // Get the current Team To Move and enemy Team
-    Teams tomove = lastMove.color;
-    Teams color;
-    for (int i = 0; i < teams.size(); i++)
-        if (i != tomove)
-            color = static_cast<Teams>(i);
+    // the team to move is the one that may have run out of moves
+    Teams color = toMove;
 
     // check checkmate
     if (!hasMoves(color)) {
         if (!isChecked(color))
             return Teams::ALL;
-        return tomove;
+        return opponent(color);
     }
 
-    // check fifty move rule
-    if (lastReversableMove == 50)
+    // check fifty move rule (the clock counts plies, as in a FEN)
+    if (lastReversableMove >= 100)
         return Teams::ALL;
 
     // check threefold repitition
-    if (std::count(positionHistory.begin(), positionHistory.end(), positionHistory.back()) >= 3)
+    if (repetitions() >= 2)
         return Teams::ALL;
 
     return Teams::NONE;
 }
 
 // Checks if a team has legal moves to play at all
-// NOTE: in a perfect world, if I could completely redo this program, I would make this cache all
-// legal moves for AttemptMove() to compare with...
 bool Game::hasMoves(const Teams& color) const {
-    for (auto& pair : teams[color]) {
-        Move move;
-
-        move.from = pair.first;
-        Piece* piece = pair.second;
-        PieceType pieceType = getPieceType(move.from);
-
-        if (piece == nullptr) {
-            std::cerr << "Dead square: " << move.from.x << move.from.y << std::endl;
-            continue;
-        }
-
-        // iterate through all the squares it can go to
-        // (maybe make a virtual iterator for this in the future)
-        for (move.to.y = 0; move.to.y < 8; move.to.y++) for (move.to.x = 0; move.to.x < 8; move.to.x++) {
-            //if (inBounds(move.to)) continue;
-            if (LegalMove(move, color, pieceType).valid) {
-                // std::cout << "Possible move: " << move.from.x << move.from.y << move.to.x << move.to.y << std::endl;
-                return true;
-            }
-        }
-    }
-
-    return false;
+    return legalMoves(color).size() > 0;
 }
 
 bool Game::isChecked(const Teams& color) const {
-    Teams otherTeam;
-    Square kingSquare = getKing(color);
-
-    for (int i = 0; i < teams.size(); i++) {
-        if (i != color)
-            otherTeam = static_cast<Teams>(i);
+    Bitboard king = board.piecesOf(color, PieceType::KING);
+    return king && board.isAttacked(std::countr_zero(king), opponent(color));
+}
 
-        for (auto& pair : teams[otherTeam]) {
-            Move move = { pair.first, kingSquare };
+bool Game::isKingSafeAfter(const CompleteMove& move) const {
+    return kingSafeAfter(board, move);
+}
 
-            if (pair.second == nullptr) {
-                std::cerr << "Dead square: " << move.from.x << move.from.y << std::endl;
-                continue;
-            }
+bool Game::isSquareAttacked(const Square& square, const Teams& by) const {
+    return inBounds(square) && board.isAttacked(squareIndex(square), by);
+}
 
-            if (LegalMove(move, otherTeam, getPieceType(move.from)).valid) {
-                std::cout << "Checking move: " << move.from.x << move.from.y << move.to.x << move.to.y << std::endl;
-                return true;
-            }
-        }
+// Only positions since the last capture or pawn move can repeat,
+// and only every other one has the same team to move.
+int Game::repetitions() const {
+    CHESS_COUNT(HISTORY_SCANS);
+    uint64_t current = getKey();
+    int count = 0;
+    int searchable = std::min(lastReversableMove, static_cast<int>(undoStack.size()));
+    for (int i = 2; i <= searchable; i += 2) {
+        if (undoStack[undoStack.size() - i].key == current)
+            count++;
     }
-    return false;
+    return count;
 }
 
 bool Game::inBounds(const Square& square) const {
@@ -444,131 +686,136 @@ bool Game::inBounds(const Square& square) const {
 //
 
 Piece* Game::getPiece(const Square& square) const {
-    for (auto team : teams) {
-        if (Piece* p = team[square]) {
-            if (p == nullptr) {
-                // This should never be reached
-                std::cerr << "Dead square: " << square.x << " " << square.y 
-                    << std::endl;
-                return nullptr;
-            }
-            return p;
-        }
-    }
-    return nullptr;
+    CHESS_COUNT(GET_PIECE);
+    if (!inBounds(square))
+        return nullptr;
+    int index = squareIndex(square);
+    return sharedPiece(board.typeAt(index), board.teamAt(index));
 }
 
 PieceType Game::getPieceType(const Square& square) const {
-    for (auto team : teams) {
-        if (Piece* p = team[square]) {
-            if (p == nullptr) {
-                // This should never be reached
-                std::cerr << "Dead square: " << square.x << " " << square.y 
-                    << std::endl;
-                return PieceType::NONE;
-            }
-            return p->Type();
-        }
-    }
-    return PieceType::NONE;
+    if (!inBounds(square))
+        return PieceType::NONE;
+    return board.typeAt(squareIndex(square));
 }
 
 Teams Game::getPieceTeam(const Square& square) const {
-    for (int i = 0; i < teams.size(); i++)
-        if (teams[i].count(square) > 0)
-            return static_cast<Teams>(i);
-    return Teams::NONE;
+    if (!inBounds(square))
+        return Teams::NONE;
+    return board.teamAt(squareIndex(square));
 }
 
 Square Game::getKing(const Teams& color) const {
-    for (const auto& pair : teams[color]) {
-        Square square = pair.first;
-        Piece* piece = pair.second;
-
-        if (piece == nullptr) {
-            // This should never be reached
-            std::cerr << "Dead square: " << square.x << " " << square.y << std::endl;
-            continue;
-        }
+    Bitboard king = board.piecesOf(color, PieceType::KING);
+    if (!king)
+        return Square{};
+    return indexSquare(std::countr_zero(king));
+}
 
-        if (piece->Type() == PieceType::KING)
-            return square;
+// Builds a PieceMap of a team's pieces, they are shared pieces that must not be deleted
+PieceMap Game::getTeamPieces(const Teams& team) const {
+    PieceMap ret;
+    Bitboard own = board.colors[team];
+    while (own) {
+        int index = popSquare(own);
+        ret[indexSquare(index)] = sharedPiece(board.typeAt(index), team);
     }
-    return Square{};
+    return ret;
+}
+
+uint64_t Game::getKey() const {
+    uint64_t key = board.key ^ zobrist.castling[castling];
+    if (enPassant >= 0)
+        key ^= zobrist.enPassant[enPassant & 7];
+    if (toMove == Teams::BLACK)
+        key ^= zobrist.blackToMove;
+    return key;
 }
 
 //
 // Mutators & private data management
 //
 
-// appends (compressed) current board state to the board history
-void Game::UpdateHistory() {
-    std::ostringstream key;
+void Game::MakeMove(const CompleteMove& move) {
+    CHESS_COUNT(MAKE_MOVE);
+    Undo undo;
+    undo.move = move;
+    undo.key = getKey();
+    undo.castling = castling;
+    undo.enPassant = enPassant;
+    undo.lastReversableMove = lastReversableMove;
 
-    // Board position
-    for (int y = 7; y >= 0; --y) {
-        for (int x = 0; x < 8; ++x) {
-            Square square{x, y};
-            Piece* piece = getPiece(square);
+    int from = squareIndex(move.move.from);
+    int to = squareIndex(move.move.to);
 
-            if (piece != nullptr) {
-                key << static_cast<int>(piece->Type()) << (getPieceTeam(square) == Teams::WHITE ? 'w' : 'b');
-            } else {
-                key << '-';
-            }
+    // perform actual move
+    if (move.moveType.castles) {
+        // castles are technically two 'moves', the king 'captures' its own rook
+        board.MovePiece(from, castleKingTo(move));
+        board.MovePiece(to, castleRookTo(move));
+    } else {
+        int captured = capturedSquare(move);
+        if (board.typeAt(captured) != PieceType::NONE)
+            undo.captured = board.RemovePiece(captured);
+
+        board.MovePiece(from, to);
+
+        // perform promotions
+        if (move.move.promotion != PieceType::NONE) {
+            board.RemovePiece(to);
+            board.PutPiece(to, move.move.promotion, move.color);
         }
-        key << "/";
     }
-    positionHistory.push_back(key.str());
-}
 
-void Game::DeletePiece(const Square& square) {
-    Piece* piece = getPiece(square);
-    Teams color = getPieceTeam(square);
-    delete piece;
-    teams[color].erase(square);
-    moved.remove(piece);
-}
+    // game status updates
+    castling &= ~(castlingLost(from) | castlingLost(to));
 
-void Game::MovePiece(const Move& move, const Teams& color) {
-    // capture support
-    Piece* captured = getPiece(move.to);
-    if (captured != nullptr) {
-        delete captured;
-        teams[getPieceTeam(move.to)].erase(move.to);
-        moved.remove(captured);
-    }
+    enPassant = -1;
+    if (move.pieceType == PieceType::PAWN && abs(move.move.to.y - move.move.from.y) == 2)
+        enPassant = (from + to) / 2;
 
-    // update PieceMap
-    teams[color][move.to] = teams[color][move.from];
-    teams[color].erase(move.from);
+    // update for the fifty-move rule
+    lastReversableMove++;
+    if (undo.captured != PieceType::NONE || move.pieceType == PieceType::PAWN)
+        lastReversableMove = 0;
 
-    // update the list of moved pieces
-    moved.push_back(teams[color][move.to]); 
+    toMove = opponent(move.color);
+    lastMove = move;
+    undoStack.push_back(undo);
 }
 
-void Game::PromotePiece(const Move& move, const Teams& color, const PieceType& type) {
+void Game::UnmakeMove() {
+    if (undoStack.empty())
+        return;
+    CHESS_COUNT(UNMAKE_MOVE);
 
-    Piece* piece = getPiece(move.from);
-    delete piece;
-    teams[color].erase(move.from);
-    moved.remove(piece);
+    const Undo& undo = undoStack.back();
+    const CompleteMove& move = undo.move;
+    int from = squareIndex(move.move.from);
+    int to = squareIndex(move.move.to);
 
-    switch (type) {
-        case PieceType::KNIGHT:
-            teams[color][move.to] = new Knight();
-            break;
-        case PieceType::BISHOP:
-            teams[color][move.to] = new Bishop();
-            break;
-        case PieceType::ROOK:
-            teams[color][move.to] = new Rook();
-            break;
-        case PieceType::QUEEN:
-            teams[color][move.to] = new Queen();
-            break;
+    if (move.moveType.castles) {
+        board.MovePiece(castleKingTo(move), from);
+        board.MovePiece(castleRookTo(move), to);
+    } else {
+        if (move.move.promotion != PieceType::NONE) {
+            board.RemovePiece(to);
+            board.PutPiece(to, PieceType::PAWN, move.color);
+        }
+
+        board.MovePiece(to, from);
+
+        if (undo.captured != PieceType::NONE)
+            board.PutPiece(capturedSquare(move), undo.captured, opponent(move.color));
     }
-    moved.push_back(teams[color][move.to]);
+
+    toMove = move.color;
+    castling = undo.castling;
+    enPassant = undo.enPassant;
+    lastReversableMove = undo.lastReversableMove;
+
+    undoStack.pop_back();
+    lastMove = undoStack.empty() ? CompleteMove() : undoStack.back().move;
 }
 
 //
@@ -593,7 +840,7 @@ std::vector<CompleteMove> interpretMove(const PieceMap& teamPieces, const Algebr
     for (auto pieceMap : teamPieces) {
         Move move = { pieceMap.first, algebraicMove.to };
         if (!pieceMap.second) {
-            std::cerr << "Dead Square: " << pieceMap.first.x << " " << pieceMap.first.y << std::endl;
+            CHESS_DIAG(DiagLevel::WARNING, DiagCategory::INPUT, "dead square: " << squareName(pieceMap.first));
             continue;
         }
 
@@ -613,7 +860,7 @@ std::vector<CompleteMove> interpretMove(const PieceMap& teamPieces, const Algebr
     }
 
     if (ret.size() == 0)
-        std::cerr << "There are 0 possible moves" << std::endl;
+        CHESS_DIAG(DiagLevel::INFO, DiagCategory::INPUT, "there are 0 possible moves");
     return ret;
 }
 
@@ -621,7 +868,7 @@ std::vector<PieceMap> FEN(std::string in) {
     std::vector<PieceMap> ret(2);
 
     int x = 0, y = 7;
-    int ptr = 0;
+    size_t ptr = 0;
 
     while (y >= 0 || ptr < in.size()) {
         if (isdigit(in[ptr])) {
@@ -634,29 +881,29 @@ std::vector<PieceMap> FEN(std::string in) {
             square.x = x;
             square.y = y;
             switch (in[ptr]) {
-                case 'p': ret[1][square] = new Pawn(2);
+                case 'p': ret[1][square] = sharedPiece(PieceType::PAWN, Teams::BLACK);
                     break;
-                case 'P': ret[0][square] = new Pawn(0);
+                case 'P': ret[0][square] = sharedPiece(PieceType::PAWN, Teams::WHITE);
                     break;
-                case 'r': ret[1][square] = new Rook;
+                case 'r': ret[1][square] = sharedPiece(PieceType::ROOK, Teams::BLACK);
                     break;
-                case 'R': ret[0][square] = new Rook;
+                case 'R': ret[0][square] = sharedPiece(PieceType::ROOK, Teams::WHITE);
                     break;
-                case 'n': ret[1][square] = new Knight;
+                case 'n': ret[1][square] = sharedPiece(PieceType::KNIGHT, Teams::BLACK);
                     break;
-                case 'N': ret[0][square] = new Knight;
+                case 'N': ret[0][square] = sharedPiece(PieceType::KNIGHT, Teams::WHITE);
                     break;
-                case 'b': ret[1][square] = new Bishop;
+                case 'b': ret[1][square] = sharedPiece(PieceType::BISHOP, Teams::BLACK);
                     break;
-                case 'B': ret[0][square] = new Bishop;
+                case 'B': ret[0][square] = sharedPiece(PieceType::BISHOP, Teams::WHITE);
                     break;
-                case 'q': ret[1][square] = new Queen;
+                case 'q': ret[1][square] = sharedPiece(PieceType::QUEEN, Teams::BLACK);
                     break;
-                case 'Q': ret[0][square] = new Queen;
+                case 'Q': ret[0][square] = sharedPiece(PieceType::QUEEN, Teams::WHITE);
                     break;
-                case 'k': ret[1][square] = new King;
+                case 'k': ret[1][square] = sharedPiece(PieceType::KING, Teams::BLACK);
                     break;
-                case 'K': ret[0][square] = new King;
+                case 'K': ret[0][square] = sharedPiece(PieceType::KING, Teams::WHITE);
                     break;
             }
             x++;
@@ -671,5 +918,42 @@ std::vector<PieceMap> FEN(std::string in) {
     return ret;
 }
 
+uint64_t perft(Game& game, int depth) {
+    MoveList moves;
+    game.GenerateMoves(game.getToMove(), moves);
+
+    // the last ply only needs to be counted, not played
+    if (depth <= 1)
+        return depth == 1 ? moves.size() : 1;
+
+    uint64_t nodes = 0;
+    for (const auto& move : moves) {
+        game.MakeMove(move);
+        nodes += perft(game, depth - 1);
+        game.UnmakeMove();
+    }
+    return nodes;
+}
+
+std::string squareName(const Square& square) {
+    return std::string(1, 'a' + square.x) + std::string(1, '1' + square.y);
+}
+
+std::string moveName(const CompleteMove& move) {
+    Square to = move.move.to;
+    if (move.moveType.castles)
+        to.x = move.moveType.castleSide == CastleSide::SHORT ? 6 : 2;
+
+    std::string ret = squareName(move.move.from) + squareName(to);
+    switch (move.move.promotion) {
+        case PieceType::QUEEN: ret += 'q'; break;
+        case PieceType::ROOK: ret += 'r'; break;
+        case PieceType::BISHOP: ret += 'b'; break;
+        case PieceType::KNIGHT: ret += 'n'; break;
+        default: break;
+    }
+    return ret;
+}
+
 // TODO add modular board/boundaries structure
 // TODO encapsulate implementation from declaration (Chess.cpp)
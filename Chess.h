@@ -1,12 +1,18 @@
 #pragma once
 #include "Piece.h"
+#include "Board.h"
+#include "FEN.h"
+#include "GameStats.h"
 #include <unordered_map>
 #include <vector>
 #include <algorithm>
 #include <cmath>
 #include <math.h>
 #include <list>
-#include <sstream>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
 #include <iostream>
 
 // Represents a certain posession over pieces
@@ -19,32 +25,104 @@
 // of these functions)
 typedef std::unordered_map<Square, Piece*> PieceMap;
 
+// Everything MakeMove() changes that cannot be worked out from the move itself,
+// so that UnmakeMove() can put it back.
+struct Undo {
+    CompleteMove move;
+    uint64_t key = 0; // of the position before the move
+    PieceType captured = PieceType::NONE;
+    unsigned char castling = 0;
+    signed char enPassant = -1;
+    int lastReversableMove = 0;
+};
+
+// Game::legalMoves()' answers, one slot per team, each kept with the position (key) it is for.
+// The slots are only allocated the first time they are needed, so a Game that never asks
+// (like the search's) stays small, and copies of a Game start out without them.
+class MoveCache {
+public:
+    MoveCache() = default;
+    MoveCache(const MoveCache&) {}
+    MoveCache& operator=(const MoveCache&) { slots.reset(); return *this; }
+    MoveCache(MoveCache&&) = default;
+    MoveCache& operator=(MoveCache&&) = default;
+
+    // the team's (WHITE or BLACK) moves, nullptr if they weren't cached for this position
+    const MoveList* find(Teams color, uint64_t key) const {
+        if (!slots || !slots->filled[color] || slots->keys[color] != key)
+            return nullptr;
+        return &slots->moves[color];
+    }
+    // the slot to fill with the team's moves in this position
+    MoveList& slot(Teams color, uint64_t key) {
+        if (!slots)
+            slots = std::make_unique<Slots>();
+        slots->keys[color] = key;
+        slots->filled[color] = true;
+        return slots->moves[color];
+    }
+
+private:
+    struct Slots {
+        MoveList moves[2];
+        uint64_t keys[2] = {};
+        bool filled[2] = {};
+    };
+    std::unique_ptr<Slots> slots;
+};
+
+// Pieces are immutable, so every square holding e.g. a white knight shares one Knight.
+// These are owned by nobody and must not be deleted.
+Piece* sharedPiece(const PieceType type, const Teams color);
+
 class Game {
 protected:
     // Invariants:
-    // pieces do not move between PieceMaps
+    // pieces do not move between teams
     // pieces cannot occupy the same square
 
-    // vector of teams
-    // each team has its own pieces
-    // squares are mapped to the pieces that occupy them
-    std::vector<PieceMap> teams;
+    // every team's pieces live on one bitboard Board (see Board.h),
+    // the PieceMaps given to the constructor are only used to fill it.
+    Board board;
+    int teamCount = 2;
 
     // necessary persistant game data
-    std::list<Piece*> moved;
+    Teams toMove = Teams::WHITE;
+    int castling = 0; // CastlingRights that are still available
+    int enPassant = -1; // square index a pawn just skipped over, -1 if none
     CompleteMove lastMove;
     int lastReversableMove = 0;
-    std::vector<std::string> positionHistory;
+    // also the position history, every Undo has the key of the position before its move.
+    // It lives in the Game's arena, if it was given one (copies of the Game go back to the heap).
+    std::pmr::vector<Undo> undoStack;
+    // plies played before the position the Game started from (for the FEN's fullmove number)
+    int pliesBefore = 0;
 
-    void UpdateHistory();
-    void DeletePiece(const Square& square);
-    void MovePiece(const Move& move, const Teams& color);
-    void PromotePiece(const Move& move, const Teams& color, const PieceType& type);
+    // what legalMoves() has generated, making a move changes the key, which is what throws them out.
+    // (mutable: a Game isn't shared between threads, so the const queries can fill it too)
+    mutable MoveCache moveCache;
+
+    void guessCastling();
+    // GenerateMoves() for one team, see Chess.cpp
+    template <Teams Us> void generateMoves(MoveList& moves) const;
+    template <Teams Us> Bitboard pinnedPieces(int king) const;
 
 public:
-    Game(int teamcount = 2);
-    Game(std::vector<PieceMap> teams);
-    ~Game();
+    // arena: where the Game keeps its history, e.g. a std::pmr::monotonic_buffer_resource
+    // shared by many short-lived Games and released all at once. It has to outlive the Game.
+    Game(int teamcount = 2, std::pmr::memory_resource* arena = nullptr);
+    // The pieces in the PieceMaps are only looked at, they stay whoever's they were
+    // (FEN() and getTeamPieces() give out shared pieces, which nobody frees).
+    Game(std::vector<PieceMap> teams, Teams toMove = Teams::WHITE, std::pmr::memory_resource* arena = nullptr);
+
+    // Sets the game up from a FEN (see FEN.h), straight onto the Board and reusing the Game's memory,
+    // so one Game can be loaded again and again without allocating.
+    // Returns false, leaving the Game as it was, if the FEN isn't valid.
+    bool Load(std::string_view fen);
+    bool Load(std::string_view fen, FENError& error);
+    // EPD has no clocks, operations is set to where the EPD operations start in the text
+    bool LoadEPD(std::string_view epd, FENError& error, size_t& operations);
+    void SetPosition(const Position& position);
 
 
     // Checks a Move's Legality and then performs the move, returns its success.
@@ -55,25 +133,71 @@ public:
     // thus only one of them can be legal. It performs that move if it exists.
     bool AttemptMoves(const std::vector<CompleteMove>& possibleMoves, int color);
 
+    // Plays a move straight out of GenerateMoves() without checking it again,
+    // and remembers how to take it back. Neither of these allocate (past the undo stack's capacity),
+    // so look-ahead can walk the move tree in place.
+    void MakeMove(const CompleteMove& move);
+    // Takes back the last move made
+    void UnmakeMove();
+
     // Infers a LegalMove from a Move using the context of the game.
     // This is the main role of this class.
-    CompleteMove LegalMove(const Move& m, const Teams color, const PieceType pieceType = PieceType::NONE, const Move& pretendMove = { }) const; 
+    CompleteMove LegalMove(const Move& m, const Teams color, const PieceType pieceType = PieceType::NONE) const; 
     CompleteMove LegalMove(const CompleteMove& m) const;
 
+    // Fills the list with every legal move the team can make, in one pass.
+    // This covers castling, en passant and every promotion piece.
+    void GenerateMoves(const Teams color, MoveList& moves) const;
+    // the same, but only generated once per position and team: AttemptMove(s), hasMoves() and
+    // getWinner() answer from here, so checking for the end of the game and then playing a move
+    // generates once, and a move typed in again after a mistake doesn't generate again.
+    // It fills the Game's cache, so none of these may be called while another thread is using
+    // the same Game. (The search walks too many positions for this to help, it calls GenerateMoves() itself.)
+    const MoveList& legalMoves(const Teams color) const;
+
     // legality queries
     Teams getWinner() const;
     bool hasMoves(const Teams& color) const;
     bool isChecked(const Teams& color) const;
+    // whether the mover's king is out of check once a move (that the piece can make) is played,
+    // for moves built without LegalMove(), like resolveSAN()'s
+    bool isKingSafeAfter(const CompleteMove& move) const;
+    // Whether any of a team's pieces attack the square, straight from the attack tables (see Attacks.h)
+    bool isSquareAttacked(const Square& square, const Teams& by) const;
     bool inBounds(const Square& square) const;
+    // How many times the current position has already been seen
+    int repetitions() const;
 
     // accessors
     Piece* getPiece(const Square& square) const;
     PieceType getPieceType(const Square& square) const;
     Teams getPieceTeam(const Square& square) const;
     Square getKing(const Teams& color) const;
-    PieceMap getTeamPieces(const Teams& team) const { return teams[team]; }
+    PieceMap getTeamPieces(const Teams& team) const;
+    // Zobrist key of the position: pieces, side to move, castling rights and en passant file
+    uint64_t getKey() const;
+    const Board& getBoard() const { return board; }
+    Teams getToMove() const { return toMove; }
+    // plies since the last capture or pawn move
+    int getHalfmoveClock() const { return lastReversableMove; }
+    // square index a pawn just skipped over, -1 if none
+    int getEnPassant() const { return enPassant; }
+    Position getPosition() const;
+    // all six FEN fields, Load(ToFEN()) gives back the same position
+    std::string ToFEN() const;
+
+    // what every Game in every thread has done so far, all zeros unless built with CHESS_STATS (see GameStats.h)
+    static GameStats Stats() { return stats::total(); }
+    static void ResetStats() { stats::reset(); }
 };
 
 // Helper functions
 std::vector<CompleteMove> interpretMove(const PieceMap& teamPieces, const AlgebraicMove& algebraicMove, const Teams& color);
+// The pieces are sharedPiece()s, so there is nothing to free
 std::vector<PieceMap> FEN(std::string in);
+// counts the leaves of the legal move tree below the position, depth plies deep
+uint64_t perft(Game& game, int depth);
+// "e4", "h8"
+std::string squareName(const Square& square);
+// long algebraic notation as UCI speaks it ("e2e4", "e7e8q"), castles are written as the king's two-square move
+std::string moveName(const CompleteMove& move);
@@ -9,7 +9,7 @@ AlgebraicMove discoverMove(std::string in) {
     AlgebraicMove ret;
 
     int n = in.size();
-    char x, y;
+    char x = 0, y = 0;
 
     if (n == 0) return ret;
 
@@ -0,0 +1,55 @@
+#include "Diagnostics.h"
+#include <atomic>
+#include <iostream>
+#include <mutex>
+
+namespace {
+    std::atomic<int> minimumLevel = static_cast<int>(DiagLevel::INFO);
+    std::atomic<unsigned> enabledCategories = static_cast<unsigned>(DiagCategory::ALL);
+
+    // messages from different threads don't interleave
+    std::mutex sinkLock;
+    std::function<void(const Diagnostic&)> sink;
+}
+
+void setDiagnosticSink(std::function<void(const Diagnostic&)> newSink) {
+    std::lock_guard<std::mutex> lock(sinkLock);
+    sink = std::move(newSink);
+}
+
+void setDiagnosticFilter(DiagLevel level, unsigned categories) {
+    minimumLevel = static_cast<int>(level);
+    enabledCategories = categories;
+}
+
+bool diagnosticEnabled(DiagLevel level, DiagCategory category) {
+    return static_cast<int>(level) <= minimumLevel.load(std::memory_order_relaxed)
+        && (static_cast<unsigned>(category) & enabledCategories.load(std::memory_order_relaxed));
+}
+
+void emitDiagnostic(DiagLevel level, DiagCategory category, std::string message) {
+    Diagnostic diagnostic = { level, category, std::move(message) };
+    std::lock_guard<std::mutex> lock(sinkLock);
+    if (sink)
+        sink(diagnostic);
+    else
+        std::cerr << "[" << levelName(level) << " " << categoryName(category) << "] " << diagnostic.message << std::endl;
+}
+
+const char* levelName(DiagLevel level) {
+    switch (level) {
+        case DiagLevel::ERROR: return "error";
+        case DiagLevel::WARNING: return "warning";
+        case DiagLevel::INFO: return "info";
+        default: return "trace";
+    }
+}
+
+const char* categoryName(DiagCategory category) {
+    switch (category) {
+        case DiagCategory::LEGALITY: return "legality";
+        case DiagCategory::INPUT: return "input";
+        case DiagCategory::SEARCH: return "search";
+        default: return "all";
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <functional>
+#include <sstream>
+#include <string>
+
+// Messages about what the library is doing (why a move was turned down, input it couldn't use...),
+// for debugging. Move validation runs millions of times in a batch, so CHESS_DIAG() compiles to
+// nothing unless the build defines CHESS_DIAGNOSTICS (cmake -DCHESS_DIAGNOSTICS=ON).
+// Code that needs to know why a move is illegal reads CompleteMove::rejection instead.
+//
+//   CHESS_DIAG(DiagLevel::INFO, DiagCategory::LEGALITY, "would leave the king in check: " << moveName(move));
+
+enum class DiagLevel {
+    ERROR,
+    WARNING,
+    INFO,
+    TRACE,
+};
+
+// one bit each, so a filter can take any of them
+enum class DiagCategory : unsigned {
+    LEGALITY = 1, // moves being checked
+    INPUT = 2, // moves and positions typed in or read from files
+    SEARCH = 4,
+    ALL = 7,
+};
+
+struct Diagnostic {
+    DiagLevel level;
+    DiagCategory category;
+    std::string message;
+};
+
+// where messages go, stderr ("[info legality] ...") until it is set. Called one message at a time.
+void setDiagnosticSink(std::function<void(const Diagnostic&)> sink);
+// only messages at least this important, in these categories, get to the sink (default: INFO, everything)
+void setDiagnosticFilter(DiagLevel level, unsigned categories = static_cast<unsigned>(DiagCategory::ALL));
+bool diagnosticEnabled(DiagLevel level, DiagCategory category);
+void emitDiagnostic(DiagLevel level, DiagCategory category, std::string message);
+
+const char* levelName(DiagLevel level);
+const char* categoryName(DiagCategory category);
+
+#if defined(CHESS_DIAGNOSTICS)
+// message is anything that can be streamed into an ostream, it isn't built unless it is going somewhere
+#define CHESS_DIAG(level, category, message) \
+    do { \
+        if (diagnosticEnabled(level, category)) { \
+            std::ostringstream diagText; \
+            diagText << message; \
+            emitDiagnostic(level, category, diagText.str()); \
+        } \
+    } while (0)
+#else
+// still compiled (never run), so a variable only used in messages isn't left unused
+#define CHESS_DIAG(level, category, message) \
+    do { \
+        if (false) { \
+            std::ostringstream diagText; \
+            diagText << message; \
+        } \
+    } while (0)
+#endif
@@ -0,0 +1,391 @@
+#include "EvalKernels.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CHESS_X86_KERNELS
+#include <immintrin.h>
+#define SSE4_TARGET __attribute__((target("sse4.2,popcnt")))
+#define AVX2_TARGET __attribute__((target("avx2,popcnt")))
+#endif
+
+// the shared bits are inlined into every kernel, so they're compiled for its instruction set too
+#if defined(__GNUC__)
+#define KERNEL_INLINE inline __attribute__((always_inline))
+#else
+#define KERNEL_INLINE inline
+#endif
+
+namespace {
+    const Bitboard notAFile = ~0x0101010101010101ULL;
+    const Bitboard notHFile = ~0x8080808080808080ULL;
+    const Bitboard notABFile = ~0x0303030303030303ULL;
+    const Bitboard notGHFile = ~0xc0c0c0c0c0c0c0c0ULL;
+
+    // a step in some direction: the bit shift (up the board if positive),
+    // and the squares it can land on without wrapping around the edge of the board
+    struct Step {
+        int shift;
+        Bitboard onBoard;
+    };
+    const Step diagonals[4] = { { 9, notAFile }, { 7, notHFile }, { -7, notAFile }, { -9, notHFile } };
+    const Step orthogonals[4] = { { 8, ~0ULL }, { -8, ~0ULL }, { 1, notAFile }, { -1, notHFile } };
+    const Step knightJumps[8] = {
+        { 17, notAFile }, { 15, notHFile }, { 10, notABFile }, { 6, notGHFile },
+        { -6, notABFile }, { -10, notGHFile }, { -15, notAFile }, { -17, notHFile },
+    };
+
+    // centipawns for every square reached (not counting our own pieces and squares the enemy pawns guard)
+    const int knightMobility = 4;
+    const int diagonalMobility = 3; // bishops and queens
+    const int orthogonalMobility = 2; // rooks and queens
+    const int doubledPawn = -12;
+    const int isolatedPawn = -10;
+    // by rank, from the pawn's side of the board
+    const int passedPawn[8] = { 0, 5, 10, 15, 30, 50, 80, 0 };
+
+    // black's pawns are looked at from black's side of the board (flipped upside down),
+    // so the pawn structure is worked out the same way for both teams
+    KERNEL_INLINE Bitboard flipVertical(Bitboard b) {
+        b = ((b >> 8) & 0x00ff00ff00ff00ffULL) | ((b & 0x00ff00ff00ff00ffULL) << 8);
+        b = ((b >> 16) & 0x0000ffff0000ffffULL) | ((b & 0x0000ffff0000ffffULL) << 16);
+        return (b >> 32) | (b << 32);
+    }
+
+    // What the kernels work out, by team. Everything heavy is in here, the rest is a few popcounts.
+    struct Reach {
+        // every square reached by the knights, along the diagonals (bishops, queens) and ranks and files (rooks, queens)
+        Bitboard knight[2];
+        Bitboard diagonal[2];
+        Bitboard orthogonal[2];
+    };
+
+    struct PawnFiles {
+        // the team's pawns from its own side of the board, filled down and up their files
+        Bitboard pawnsDown[2];
+        Bitboard pawnsUp[2];
+        // the other team's pawns, from this team's side, filled down their files
+        Bitboard enemyDown[2];
+    };
+
+    // the kernels' input, the same for all of them
+    struct Pieces {
+        Bitboard knights[2], diagonal[2], orthogonal[2];
+        Bitboard empty;
+    };
+
+    struct Pawns {
+        Bitboard pawns[2]; // from each team's own side
+        Bitboard enemy[2]; // the other team's, from this team's side
+    };
+
+    KERNEL_INLINE Pieces piecesOf(const Board& board) {
+        Pieces pieces;
+        for (int color = 0; color < 2; color++) {
+            Bitboard own = board.colors[color];
+            pieces.knights[color] = board.pieces[static_cast<int>(PieceType::KNIGHT)] & own;
+            pieces.diagonal[color] = (board.pieces[static_cast<int>(PieceType::BISHOP)] | board.pieces[static_cast<int>(PieceType::QUEEN)]) & own;
+            pieces.orthogonal[color] = (board.pieces[static_cast<int>(PieceType::ROOK)] | board.pieces[static_cast<int>(PieceType::QUEEN)]) & own;
+        }
+        pieces.empty = ~board.occupied();
+        return pieces;
+    }
+
+    KERNEL_INLINE Pawns pawnsOf(const Board& board) {
+        Bitboard white = board.piecesOf(Teams::WHITE, PieceType::PAWN);
+        Bitboard black = board.piecesOf(Teams::BLACK, PieceType::PAWN);
+        return { { white, flipVertical(black) }, { black, flipVertical(white) } };
+    }
+
+    KERNEL_INLINE Bitboard east(Bitboard b) { return (b << 1) & notAFile; }
+    KERNEL_INLINE Bitboard west(Bitboard b) { return (b >> 1) & notHFile; }
+
+    KERNEL_INLINE int mobilityScore(const Board& board, const Reach& reach) {
+        Bitboard white = board.piecesOf(Teams::WHITE, PieceType::PAWN);
+        Bitboard black = board.piecesOf(Teams::BLACK, PieceType::PAWN);
+        Bitboard pawnAttacks[2] = {
+            ((white << 9) & notAFile) | ((white << 7) & notHFile),
+            ((black >> 7) & notAFile) | ((black >> 9) & notHFile),
+        };
+
+        int score[2] = {};
+        for (int color = 0; color < 2; color++) {
+            Bitboard area = ~board.colors[color] & ~pawnAttacks[1 - color];
+            score[color] += knightMobility * std::popcount(reach.knight[color] & area);
+            score[color] += diagonalMobility * std::popcount(reach.diagonal[color] & area);
+            score[color] += orthogonalMobility * std::popcount(reach.orthogonal[color] & area);
+        }
+        return score[Teams::WHITE] - score[Teams::BLACK];
+    }
+
+    KERNEL_INLINE int pawnScore(const Pawns& pawns, const PawnFiles& files) {
+        int score[2] = {};
+        for (int color = 0; color < 2; color++) {
+            Bitboard own = pawns.pawns[color];
+            // another of ours further up the file
+            Bitboard doubled = own & (files.pawnsDown[color] >> 8);
+            Bitboard taken = files.pawnsDown[color] | files.pawnsUp[color];
+            Bitboard isolated = own & ~(east(taken) | west(taken));
+            // nothing of theirs ahead, on this file or the next ones
+            Bitboard front = files.enemyDown[color] >> 8;
+            Bitboard passed = own & ~(front | east(front) | west(front));
+
+            score[color] += doubledPawn * std::popcount(doubled) + isolatedPawn * std::popcount(isolated);
+            while (passed)
+                score[color] += passedPawn[popSquare(passed) >> 3];
+        }
+        return score[Teams::WHITE] - score[Teams::BLACK];
+    }
+
+    // SCALAR, one board at a time
+
+    Bitboard shifted(Bitboard b, int shift) { return shift > 0 ? b << shift : b >> -shift; }
+
+    // the squares the sliders reach in one direction, up to and including the first piece in the way
+    // (Kogge-Stone: doubling the distance every step, three steps cover the board)
+    Bitboard slide(Bitboard sliders, Bitboard empty, const Step& step) {
+        empty &= step.onBoard;
+        sliders |= empty & shifted(sliders, step.shift);
+        empty &= shifted(empty, step.shift);
+        sliders |= empty & shifted(sliders, step.shift * 2);
+        empty &= shifted(empty, step.shift * 2);
+        sliders |= empty & shifted(sliders, step.shift * 4);
+        return shifted(sliders, step.shift) & step.onBoard;
+    }
+
+    Bitboard fillDown(Bitboard b) {
+        b |= b >> 8;
+        b |= b >> 16;
+        return b | b >> 32;
+    }
+
+    Bitboard fillUp(Bitboard b) {
+        b |= b << 8;
+        b |= b << 16;
+        return b | b << 32;
+    }
+
+    int mobilityScalar(const Board& board) {
+        Pieces pieces = piecesOf(board);
+        Reach reach = {};
+        for (int color = 0; color < 2; color++) {
+            for (const Step& step : knightJumps)
+                reach.knight[color] |= shifted(pieces.knights[color], step.shift) & step.onBoard;
+            for (int i = 0; i < 4; i++) {
+                reach.diagonal[color] |= slide(pieces.diagonal[color], pieces.empty, diagonals[i]);
+                reach.orthogonal[color] |= slide(pieces.orthogonal[color], pieces.empty, orthogonals[i]);
+            }
+        }
+        return mobilityScore(board, reach);
+    }
+
+    int pawnsScalar(const Board& board) {
+        Pawns pawns = pawnsOf(board);
+        PawnFiles files;
+        for (int color = 0; color < 2; color++) {
+            files.pawnsDown[color] = fillDown(pawns.pawns[color]);
+            files.pawnsUp[color] = fillUp(pawns.pawns[color]);
+            files.enemyDown[color] = fillDown(pawns.enemy[color]);
+        }
+        return pawnScore(pawns, files);
+    }
+
+#if defined(CHESS_X86_KERNELS)
+    // SSE4, both teams at once: lane 0 is white, lane 1 black
+
+    SSE4_TARGET inline __m128i pair(Bitboard white, Bitboard black) {
+        return _mm_set_epi64x(static_cast<long long>(black), static_cast<long long>(white));
+    }
+
+    SSE4_TARGET inline __m128i shifted2(__m128i b, int shift) {
+        return shift > 0 ? _mm_sll_epi64(b, _mm_cvtsi32_si128(shift)) : _mm_srl_epi64(b, _mm_cvtsi32_si128(-shift));
+    }
+
+    SSE4_TARGET inline __m128i slide2(__m128i sliders, __m128i empty, const Step& step) {
+        __m128i onBoard = _mm_set1_epi64x(static_cast<long long>(step.onBoard));
+        empty = _mm_and_si128(empty, onBoard);
+        sliders = _mm_or_si128(sliders, _mm_and_si128(empty, shifted2(sliders, step.shift)));
+        empty = _mm_and_si128(empty, shifted2(empty, step.shift));
+        sliders = _mm_or_si128(sliders, _mm_and_si128(empty, shifted2(sliders, step.shift * 2)));
+        empty = _mm_and_si128(empty, shifted2(empty, step.shift * 2));
+        sliders = _mm_or_si128(sliders, _mm_and_si128(empty, shifted2(sliders, step.shift * 4)));
+        return _mm_and_si128(shifted2(sliders, step.shift), onBoard);
+    }
+
+    SSE4_TARGET inline void unpair(__m128i b, Bitboard (&out)[2]) {
+        out[0] = static_cast<Bitboard>(_mm_extract_epi64(b, 0));
+        out[1] = static_cast<Bitboard>(_mm_extract_epi64(b, 1));
+    }
+
+    SSE4_TARGET int mobilitySSE4(const Board& board) {
+        Pieces pieces = piecesOf(board);
+        __m128i empty = _mm_set1_epi64x(static_cast<long long>(pieces.empty));
+
+        __m128i knights = pair(pieces.knights[0], pieces.knights[1]);
+        __m128i knight = _mm_setzero_si128();
+        for (const Step& step : knightJumps)
+            knight = _mm_or_si128(knight, _mm_and_si128(shifted2(knights, step.shift), _mm_set1_epi64x(static_cast<long long>(step.onBoard))));
+
+        __m128i diagonalSliders = pair(pieces.diagonal[0], pieces.diagonal[1]);
+        __m128i orthogonalSliders = pair(pieces.orthogonal[0], pieces.orthogonal[1]);
+        __m128i diagonal = _mm_setzero_si128(), orthogonal = _mm_setzero_si128();
+        for (int i = 0; i < 4; i++) {
+            diagonal = _mm_or_si128(diagonal, slide2(diagonalSliders, empty, diagonals[i]));
+            orthogonal = _mm_or_si128(orthogonal, slide2(orthogonalSliders, empty, orthogonals[i]));
+        }
+
+        Reach reach;
+        unpair(knight, reach.knight);
+        unpair(diagonal, reach.diagonal);
+        unpair(orthogonal, reach.orthogonal);
+        return mobilityScore(board, reach);
+    }
+
+    SSE4_TARGET int pawnsSSE4(const Board& board) {
+        Pawns pawns = pawnsOf(board);
+        // down the files: our pawns and theirs, up the files: ours
+        __m128i down = pair(pawns.pawns[0], pawns.pawns[1]);
+        __m128i enemy = pair(pawns.enemy[0], pawns.enemy[1]);
+        __m128i up = down;
+        for (int shift = 8; shift <= 32; shift *= 2) {
+            __m128i count = _mm_cvtsi32_si128(shift);
+            down = _mm_or_si128(down, _mm_srl_epi64(down, count));
+            enemy = _mm_or_si128(enemy, _mm_srl_epi64(enemy, count));
+            up = _mm_or_si128(up, _mm_sll_epi64(up, count));
+        }
+
+        PawnFiles files;
+        unpair(down, files.pawnsDown);
+        unpair(up, files.pawnsUp);
+        unpair(enemy, files.enemyDown);
+        return pawnScore(pawns, files);
+    }
+
+    // AVX2, four directions at once. Every lane shifts by its own amount (up the board
+    // with sllv, down with srlv, the other one shifts by 64, which gives 0)
+
+    struct Steps4 {
+        __m256i up[3], down[3]; // by 1, 2 and 4 steps
+        __m256i onBoard;
+    };
+
+    AVX2_TARGET inline Steps4 steps4(const Step* steps) {
+        Steps4 out;
+        for (int times = 0; times < 3; times++) {
+            long long up[4], down[4];
+            for (int i = 0; i < 4; i++) {
+                int shift = steps[i].shift << times;
+                up[i] = shift > 0 ? shift : 64;
+                down[i] = shift < 0 ? -shift : 64;
+            }
+            out.up[times] = _mm256_set_epi64x(up[3], up[2], up[1], up[0]);
+            out.down[times] = _mm256_set_epi64x(down[3], down[2], down[1], down[0]);
+        }
+        out.onBoard = _mm256_set_epi64x(static_cast<long long>(steps[3].onBoard), static_cast<long long>(steps[2].onBoard),
+            static_cast<long long>(steps[1].onBoard), static_cast<long long>(steps[0].onBoard));
+        return out;
+    }
+
+    AVX2_TARGET inline __m256i shifted4(__m256i b, const Steps4& steps, int times) {
+        return _mm256_or_si256(_mm256_sllv_epi64(b, steps.up[times]), _mm256_srlv_epi64(b, steps.down[times]));
+    }
+
+    AVX2_TARGET inline __m256i slide4(__m256i sliders, __m256i empty, const Steps4& steps) {
+        empty = _mm256_and_si256(empty, steps.onBoard);
+        sliders = _mm256_or_si256(sliders, _mm256_and_si256(empty, shifted4(sliders, steps, 0)));
+        empty = _mm256_and_si256(empty, shifted4(empty, steps, 0));
+        sliders = _mm256_or_si256(sliders, _mm256_and_si256(empty, shifted4(sliders, steps, 1)));
+        empty = _mm256_and_si256(empty, shifted4(empty, steps, 1));
+        sliders = _mm256_or_si256(sliders, _mm256_and_si256(empty, shifted4(sliders, steps, 2)));
+        return _mm256_and_si256(shifted4(sliders, steps, 0), steps.onBoard);
+    }
+
+    // the union of the four lanes
+    AVX2_TARGET inline Bitboard merge4(__m256i b) {
+        __m128i half = _mm_or_si128(_mm256_castsi256_si128(b), _mm256_extracti128_si256(b, 1));
+        return static_cast<Bitboard>(_mm_cvtsi128_si64(_mm_or_si128(half, _mm_unpackhi_epi64(half, half))));
+    }
+
+    AVX2_TARGET int mobilityAVX2(const Board& board) {
+        // only worked out once, the first time through
+        static const Steps4 diagonal4 = steps4(diagonals);
+        static const Steps4 orthogonal4 = steps4(orthogonals);
+        static const Steps4 knight4[2] = { steps4(knightJumps), steps4(knightJumps + 4) };
+
+        Pieces pieces = piecesOf(board);
+        __m256i empty = _mm256_set1_epi64x(static_cast<long long>(pieces.empty));
+
+        Reach reach;
+        for (int color = 0; color < 2; color++) {
+            __m256i knights = _mm256_set1_epi64x(static_cast<long long>(pieces.knights[color]));
+            __m256i knight = _mm256_or_si256(_mm256_and_si256(shifted4(knights, knight4[0], 0), knight4[0].onBoard),
+                _mm256_and_si256(shifted4(knights, knight4[1], 0), knight4[1].onBoard));
+            reach.knight[color] = merge4(knight);
+
+            __m256i diagonal = slide4(_mm256_set1_epi64x(static_cast<long long>(pieces.diagonal[color])), empty, diagonal4);
+            __m256i orthogonal = slide4(_mm256_set1_epi64x(static_cast<long long>(pieces.orthogonal[color])), empty, orthogonal4);
+            reach.diagonal[color] = merge4(diagonal);
+            reach.orthogonal[color] = merge4(orthogonal);
+        }
+        return mobilityScore(board, reach);
+    }
+
+    AVX2_TARGET int pawnsAVX2(const Board& board) {
+        Pawns pawns = pawnsOf(board);
+        // lanes: white's pawns, black's, and each one's enemy pawns, filled down; the first two filled up as well
+        __m256i down = _mm256_set_epi64x(static_cast<long long>(pawns.enemy[1]), static_cast<long long>(pawns.enemy[0]),
+            static_cast<long long>(pawns.pawns[1]), static_cast<long long>(pawns.pawns[0]));
+        __m256i up = down;
+        for (int shift = 8; shift <= 32; shift *= 2) {
+            __m128i count = _mm_cvtsi32_si128(shift);
+            down = _mm256_or_si256(down, _mm256_srl_epi64(down, count));
+            up = _mm256_or_si256(up, _mm256_sll_epi64(up, count));
+        }
+        alignas(32) Bitboard downLanes[4], upLanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(downLanes), down);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(upLanes), up);
+        PawnFiles files;
+        for (int color = 0; color < 2; color++) {
+            files.pawnsDown[color] = downLanes[color];
+            files.pawnsUp[color] = upLanes[color];
+            files.enemyDown[color] = downLanes[2 + color];
+        }
+        return pawnScore(pawns, files);
+    }
+#endif
+}
+
+bool kernelSupported(EvalKernel kernel) {
+    switch (kernel) {
+        case EvalKernel::SCALAR: return true;
+#if defined(CHESS_X86_KERNELS)
+        case EvalKernel::SSE4: return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+        case EvalKernel::AVX2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+        default: return false;
+    }
+}
+
+EvalKernel bestKernel() {
+    static const EvalKernel best = kernelSupported(EvalKernel::AVX2) ? EvalKernel::AVX2
+        : kernelSupported(EvalKernel::SSE4) ? EvalKernel::SSE4 : EvalKernel::SCALAR;
+    return best;
+}
+
+EvalTerms evalTerms(EvalKernel kernel) {
+    if (!kernelSupported(kernel))
+        return { mobilityScalar, pawnsScalar };
+#if defined(CHESS_X86_KERNELS)
+    if (kernel == EvalKernel::SSE4)
+        return { mobilitySSE4, pawnsSSE4 };
+    if (kernel == EvalKernel::AVX2)
+        return { mobilityAVX2, pawnsAVX2 };
+#endif
+    return { mobilityScalar, pawnsScalar };
+}
+
+const char* kernelName(EvalKernel kernel) {
+    switch (kernel) {
+        case EvalKernel::SSE4: return "sse4";
+        case EvalKernel::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
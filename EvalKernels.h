@@ -0,0 +1,32 @@
+#pragma once
+#include "Board.h"
+
+// The positional terms of the evaluation: mobility and pawn structure.
+// Unlike the piece-square sums these depend on every piece at once, so they're worked out
+// from the bitboards for every position, set-wise (all the knights at once, every bishop's
+// diagonals at once...). That is mostly shifting and masking whole boards, which the vector
+// units do several at a time, so there's one kernel per instruction set and the best one the
+// CPU has is picked when the program starts. They all give the same answer.
+
+enum class EvalKernel {
+    SCALAR,
+    SSE4, // SSE 4.2 and popcnt
+    AVX2,
+};
+
+// a positional term, in centipawns for white
+typedef int (*EvalTerm)(const Board& board);
+
+// one kernel's terms
+struct EvalTerms {
+    EvalTerm mobility;
+    // depends on nothing but the pawns (so it can be cached by Board::pawnKey, see PawnHashTable.h)
+    EvalTerm pawns;
+};
+
+// false if the CPU (or the compiler) can't run it
+bool kernelSupported(EvalKernel kernel);
+// the fastest supported kernel
+EvalKernel bestKernel();
+EvalTerms evalTerms(EvalKernel kernel);
+const char* kernelName(EvalKernel kernel);
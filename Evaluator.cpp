@@ -0,0 +1,20 @@
+#include "Evaluator.h"
+#include <algorithm>
+
+int Evaluator::Evaluate(const Board& board, Teams toMove) {
+    Teams other = opponent(toMove);
+    int middlegame = board.middlegame[toMove] - board.middlegame[other];
+    int endgame = board.endgame[toMove] - board.endgame[other];
+
+    // promotions can take the phase past a full board
+    int phase = std::min(board.phase, MAX_PHASE);
+    int score = (middlegame * phase + endgame * (MAX_PHASE - phase)) / MAX_PHASE;
+
+    int pawns;
+    if (!pawnTable.Probe(board.pawnKey, pawns)) {
+        pawns = terms.pawns(board);
+        pawnTable.Store(board.pawnKey, pawns);
+    }
+    int positional = terms.mobility(board) + pawns;
+    return score + (toMove == Teams::WHITE ? positional : -positional);
+}
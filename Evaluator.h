@@ -0,0 +1,25 @@
+#pragma once
+#include "Chess.h"
+#include "EvalKernels.h"
+#include "PawnHashTable.h"
+
+// Scores a position for the team to move, in centipawns.
+// Material and piece-square tables, tapered between the middlegame and the endgame by the pieces
+// left on the board. The Board keeps the sums up to date as pieces move (see PieceSquareTables.h),
+// so scoring a position costs the same however many pieces there are.
+// Mobility and pawn structure are added on top by the eval kernels (see EvalKernels.h),
+// the pawn structure only when the pawns aren't in the PawnHashTable already.
+class Evaluator {
+public:
+    explicit Evaluator(EvalKernel kernel = bestKernel()) : terms(evalTerms(kernel)) {}
+
+    int Evaluate(const Game& game) { return Evaluate(game.getBoard(), game.getToMove()); }
+    int Evaluate(const Board& board, Teams toMove);
+
+    const PawnHashStats& pawnStats() const { return pawnTable.getStats(); }
+    void ResetStats() { pawnTable.ResetStats(); }
+
+private:
+    EvalTerms terms;
+    PawnHashTable pawnTable;
+};
@@ -0,0 +1,273 @@
+#include "FEN.h"
+#include <charconv>
+#include <cstring>
+
+namespace {
+    const char* fieldNames[] = { "none", "board", "side to move", "castling", "en passant", "halfmove clock", "fullmove number" };
+    // piece letters by PieceType, lowercase is black
+    const char* pieceLetters = " pnbrqk";
+
+    bool fail(FENError& error, FENField field, size_t offset, const char* reason) {
+        error.field = field;
+        error.offset = offset;
+        error.reason = reason;
+        return false;
+    }
+
+    // fields are separated by exactly one space
+    bool separator(std::string_view text, size_t& i, FENError& error, FENField next) {
+        if (i >= text.size())
+            return fail(error, next, i, "missing");
+        if (text[i] != ' ')
+            return fail(error, next, i, "expected a space");
+        i++;
+        if (i >= text.size() || text[i] == ' ')
+            return fail(error, next, i, "missing");
+        return true;
+    }
+
+    bool endOfField(std::string_view text, size_t i) {
+        return i >= text.size() || text[i] == ' ';
+    }
+
+    bool parseBoard(std::string_view text, size_t& i, Position& position, FENError& error) {
+        int x = 0, y = 7;
+        bool lastWasDigit = false;
+        for (; !endOfField(text, i); i++) {
+            char c = text[i];
+            if (c == '/') {
+                if (x != 8)
+                    return fail(error, FENField::BOARD, i, "rank does not have 8 squares");
+                if (y == 0)
+                    return fail(error, FENField::BOARD, i, "more than 8 ranks");
+                x = 0;
+                y--;
+                lastWasDigit = false;
+                continue;
+            }
+
+            if (c >= '1' && c <= '8') {
+                if (lastWasDigit)
+                    return fail(error, FENField::BOARD, i, "two numbers in a row");
+                x += c - '0';
+                if (x > 8)
+                    return fail(error, FENField::BOARD, i, "rank has more than 8 squares");
+                lastWasDigit = true;
+                continue;
+            }
+
+            bool isLetter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+            const char* letter = isLetter ? strchr(pieceLetters + 1, c | 0x20) : nullptr;
+            if (letter == nullptr)
+                return fail(error, FENField::BOARD, i, "not a piece");
+            if (x > 7)
+                return fail(error, FENField::BOARD, i, "rank has more than 8 squares");
+
+            PieceType type = static_cast<PieceType>(letter - pieceLetters);
+            if (type == PieceType::PAWN && (y == 0 || y == 7))
+                return fail(error, FENField::BOARD, i, "pawn on the first or last rank");
+            position.board.PutPiece(y * 8 + x, type, c < 'a' ? Teams::WHITE : Teams::BLACK);
+            x++;
+            lastWasDigit = false;
+        }
+
+        if (x != 8 || y != 0)
+            return fail(error, FENField::BOARD, i, "board does not have 8 ranks of 8 squares");
+
+        const Board& board = position.board;
+        Bitboard kings = board.pieces[static_cast<int>(PieceType::KING)];
+        if (std::popcount(kings & board.colors[Teams::WHITE]) != 1 || std::popcount(kings & board.colors[Teams::BLACK]) != 1)
+            return fail(error, FENField::BOARD, 0, "each team needs exactly one king");
+        return true;
+    }
+
+    bool parseSide(std::string_view text, size_t& i, Position& position, FENError& error) {
+        if (text[i] != 'w' && text[i] != 'b')
+            return fail(error, FENField::SIDE, i, "not w or b");
+        position.toMove = text[i] == 'w' ? Teams::WHITE : Teams::BLACK;
+        i++;
+        if (!endOfField(text, i))
+            return fail(error, FENField::SIDE, i, "not w or b");
+        return true;
+    }
+
+    bool parseCastling(std::string_view text, size_t& i, Position& position, FENError& error) {
+        if (text[i] == '-') {
+            i++;
+            if (!endOfField(text, i))
+                return fail(error, FENField::CASTLING, i, "nothing can follow -");
+            return true;
+        }
+
+        const Board& board = position.board;
+        for (; !endOfField(text, i); i++) {
+            int right;
+            switch (text[i]) {
+                case 'K': right = WHITE_SHORT; break;
+                case 'Q': right = WHITE_LONG; break;
+                case 'k': right = BLACK_SHORT; break;
+                case 'q': right = BLACK_LONG; break;
+                default: return fail(error, FENField::CASTLING, i, "not one of KQkq");
+            }
+            if (position.castling & right)
+                return fail(error, FENField::CASTLING, i, "right given twice");
+
+            // the move generator expects the king and rook on their starting squares
+            Teams color = (right & (WHITE_SHORT | WHITE_LONG)) ? Teams::WHITE : Teams::BLACK;
+            int rank = color == Teams::WHITE ? 0 : 56;
+            int rook = rank + ((right & (WHITE_SHORT | BLACK_SHORT)) ? 7 : 0);
+            if (board.typeAt(rank + 4) != PieceType::KING || board.teamAt(rank + 4) != color)
+                return fail(error, FENField::CASTLING, i, "king not on its square");
+            if (board.typeAt(rook) != PieceType::ROOK || board.teamAt(rook) != color)
+                return fail(error, FENField::CASTLING, i, "rook not on its square");
+            position.castling |= right;
+        }
+        return true;
+    }
+
+    bool parseEnPassant(std::string_view text, size_t& i, Position& position, FENError& error) {
+        if (text[i] == '-') {
+            i++;
+            if (!endOfField(text, i))
+                return fail(error, FENField::EN_PASSANT, i, "nothing can follow -");
+            return true;
+        }
+
+        size_t start = i;
+        if (i + 1 >= text.size() || text[i] < 'a' || text[i] > 'h' || text[i + 1] < '1' || text[i + 1] > '8' || !endOfField(text, i + 2))
+            return fail(error, FENField::EN_PASSANT, start, "not a square");
+        int x = text[i] - 'a';
+        int y = text[i + 1] - '1';
+        i += 2;
+
+        // the pawn that just moved is in front of the square, where it came from is empty
+        Teams mover = opponent(position.toMove);
+        int skippedRank = mover == Teams::WHITE ? 2 : 5;
+        int forward = mover == Teams::WHITE ? 8 : -8;
+        if (y != skippedRank)
+            return fail(error, FENField::EN_PASSANT, start, "not on the rank a pawn of the last team to move skips");
+
+        const Board& board = position.board;
+        int index = y * 8 + x;
+        if (board.typeAt(index + forward) != PieceType::PAWN || board.teamAt(index + forward) != mover)
+            return fail(error, FENField::EN_PASSANT, start, "no pawn just moved past it");
+        if (board.occupied() & (squareBit(index) | squareBit(index - forward)))
+            return fail(error, FENField::EN_PASSANT, start, "no pawn just moved past it");
+        position.enPassant = index;
+        return true;
+    }
+
+    bool parseNumber(std::string_view text, size_t& i, int& value, int minimum, FENField field, FENError& error) {
+        if (text[i] < '0' || text[i] > '9')
+            return fail(error, field, i, "not a number");
+        auto [end, problem] = std::from_chars(text.data() + i, text.data() + text.size(), value);
+        size_t next = end - text.data();
+        if (problem != std::errc() || !endOfField(text, next))
+            return fail(error, field, i, "not a number");
+        if (value < minimum)
+            return fail(error, field, i, "too small");
+        i = next;
+        return true;
+    }
+
+    // board, side to move, castling and en passant, as FEN and EPD share them.
+    // Trailing whitespace (like a line's \r) is cut off the text.
+    bool parseFields(std::string_view& text, size_t& i, Position& position, FENError& error) {
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r' || text.back() == '\n'))
+            text.remove_suffix(1);
+        position = Position();
+        error = FENError();
+        i = 0;
+        if (text.empty())
+            return fail(error, FENField::BOARD, 0, "missing");
+
+        return parseBoard(text, i, position, error)
+            && separator(text, i, error, FENField::SIDE) && parseSide(text, i, position, error)
+            && separator(text, i, error, FENField::CASTLING) && parseCastling(text, i, position, error)
+            && separator(text, i, error, FENField::EN_PASSANT) && parseEnPassant(text, i, position, error);
+    }
+}
+
+std::string describe(const FENError& error) {
+    return std::string(fieldNames[static_cast<int>(error.field)]) + " at " + std::to_string(error.offset) + ": " + error.reason;
+}
+
+bool parseFEN(std::string_view text, Position& position, FENError& error) {
+    size_t i;
+    if (!parseFields(text, i, position, error))
+        return false;
+
+    if (!separator(text, i, error, FENField::HALFMOVE) || !parseNumber(text, i, position.halfmoveClock, 0, FENField::HALFMOVE, error))
+        return false;
+    if (!separator(text, i, error, FENField::FULLMOVE) || !parseNumber(text, i, position.fullmoveNumber, 1, FENField::FULLMOVE, error))
+        return false;
+
+    if (i < text.size())
+        return fail(error, FENField::FULLMOVE, i, "unexpected text after the FEN");
+    return true;
+}
+
+bool parseEPD(std::string_view text, Position& position, FENError& error, size_t& operations) {
+    size_t i;
+    if (!parseFields(text, i, position, error))
+        return false;
+
+    while (i < text.size() && text[i] == ' ')
+        i++;
+    operations = i;
+    return true;
+}
+
+size_t writeFEN(const Position& position, char* out) {
+    char* at = out;
+    const Board& board = position.board;
+
+    for (int y = 7; y >= 0; y--) {
+        int empty = 0;
+        for (int x = 0; x < 8; x++) {
+            int index = y * 8 + x;
+            PieceType type = board.typeAt(index);
+            if (type == PieceType::NONE) {
+                empty++;
+                continue;
+            }
+            if (empty > 0)
+                *at++ = '0' + empty;
+            empty = 0;
+            char letter = pieceLetters[static_cast<int>(type)];
+            *at++ = board.teamAt(index) == Teams::WHITE ? letter - 'a' + 'A' : letter;
+        }
+        if (empty > 0)
+            *at++ = '0' + empty;
+        if (y > 0)
+            *at++ = '/';
+    }
+
+    *at++ = ' ';
+    *at++ = position.toMove == Teams::WHITE ? 'w' : 'b';
+
+    *at++ = ' ';
+    if (position.castling == 0)
+        *at++ = '-';
+    if (position.castling & WHITE_SHORT) *at++ = 'K';
+    if (position.castling & WHITE_LONG) *at++ = 'Q';
+    if (position.castling & BLACK_SHORT) *at++ = 'k';
+    if (position.castling & BLACK_LONG) *at++ = 'q';
+
+    *at++ = ' ';
+    if (position.enPassant < 0)
+        *at++ = '-';
+    else {
+        *at++ = 'a' + (position.enPassant & 7);
+        *at++ = '1' + (position.enPassant >> 3);
+    }
+
+    // ints have at most 11 characters, which MAX_FEN_LENGTH leaves room for
+    *at++ = ' ';
+    at = std::to_chars(at, out + MAX_FEN_LENGTH, position.halfmoveClock).ptr;
+    *at++ = ' ';
+    at = std::to_chars(at, out + MAX_FEN_LENGTH, position.fullmoveNumber).ptr;
+
+    *at = '\0';
+    return at - out;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "Board.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Reading and writing positions as FEN (and EPD, which is FEN's first four fields
+// followed by operations). Neither direction allocates, so they are cheap enough to
+// run over millions of positions.
+
+inline constexpr std::string_view START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Everything a FEN says about a position
+struct Position {
+    Board board;
+    Teams toMove = Teams::WHITE;
+    int castling = 0; // CastlingRights
+    int enPassant = -1; // square index the last pawn skipped over, -1 if none
+    int halfmoveClock = 0; // plies since the last capture or pawn move
+    int fullmoveNumber = 1; // starts at 1, goes up after every black move
+};
+
+// Which field a FEN went wrong in
+enum class FENField {
+    NONE,
+    BOARD,
+    SIDE,
+    CASTLING,
+    EN_PASSANT,
+    HALFMOVE,
+    FULLMOVE,
+};
+
+struct FENError {
+    FENField field = FENField::NONE;
+    size_t offset = 0; // index of the offending character
+    const char* reason = "";
+};
+
+// e.g. "castling at 45: rook not on its square"
+std::string describe(const FENError& error);
+
+// A FEN is strict: all six fields, one space between each, and a position that can be played
+// (one king each, no pawns on the first or last rank, castling rights that have their king and rook,
+// an en passant square right behind the pawn that just moved).
+// Returns false, filling in the error, if anything is wrong.
+bool parseFEN(std::string_view text, Position& position, FENError& error);
+// Same rules, but only the first four fields. operations is set to where the EPD operations
+// start (the end of the text if there aren't any).
+bool parseEPD(std::string_view text, Position& position, FENError& error, size_t& operations);
+
+// the longest FEN writeFEN can produce
+const size_t MAX_FEN_LENGTH = 120;
+// writes the FEN into out (which needs room for MAX_FEN_LENGTH + 1 chars, it is NUL terminated), returns its length
+size_t writeFEN(const Position& position, char* out);
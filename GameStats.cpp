@@ -0,0 +1,144 @@
+#include "GameStats.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace {
+    // every thread's counters, and what the threads that have finished counted
+    struct Registry {
+        std::mutex lock;
+        std::vector<stats::ThreadStats*> threads;
+        GameStats finished;
+
+        // the totals go to CHESS_STATS_JSON on the way out (the main thread's counters are
+        // folded into finished before this runs, thread_locals go before statics)
+        ~Registry() {
+#if defined(CHESS_STATS)
+            const char* path = std::getenv("CHESS_STATS_JSON");
+            if (path == nullptr || *path == '\0')
+                return;
+            std::string json = finished.ToJSON();
+            if (std::string(path) == "-")
+                std::cerr << json << std::endl;
+            else
+                std::ofstream(path) << json << std::endl;
+#endif
+        }
+    };
+
+    Registry& registry() {
+        static Registry registry;
+        return registry;
+    }
+
+#if defined(CHESS_STATS)
+    // made when the program starts, so it is still around to write the JSON at exit
+    const bool registered = (registry(), true);
+#endif
+}
+
+GameStats& GameStats::operator+=(const GameStats& other) {
+    for (int i = 0; i < static_cast<int>(Counter::COUNT); i++)
+        counters[i] += other.counters[i];
+    for (int i = 0; i < static_cast<int>(Phase::COUNT); i++)
+        nanoseconds[i] += other.nanoseconds[i];
+    legalMoveDepth = std::max(legalMoveDepth, other.legalMoveDepth);
+    return *this;
+}
+
+std::string GameStats::ToJSON() const {
+    std::string json = "{\"counters\": {";
+    for (int i = 0; i < static_cast<int>(Counter::COUNT); i++) {
+        json += i ? ", \"" : "\"";
+        json += counterName(static_cast<Counter>(i));
+        json += "\": " + std::to_string(counters[i]);
+    }
+    json += "}, \"seconds\": {";
+    for (int i = 0; i < static_cast<int>(Phase::COUNT); i++) {
+        char seconds[32];
+        snprintf(seconds, sizeof(seconds), "%.6f", nanoseconds[i] * 1e-9);
+        json += i ? ", \"" : "\"";
+        json += phaseName(static_cast<Phase>(i));
+        json += "\": ";
+        json += seconds;
+    }
+    json += "}, \"legal_move_depth\": " + std::to_string(legalMoveDepth) + "}";
+    return json;
+}
+
+const char* counterName(Counter counter) {
+    switch (counter) {
+        case Counter::LEGAL_MOVE: return "legal_move";
+        case Counter::GET_PIECE: return "get_piece";
+        case Counter::MAKE_MOVE: return "make_move";
+        case Counter::UNMAKE_MOVE: return "unmake_move";
+        case Counter::GENERATE_MOVES: return "generate_moves";
+        case Counter::HISTORY_SCANS: return "history_scans";
+        case Counter::MOVE_CACHE_HIT: return "move_cache_hit";
+        case Counter::MOVE_CACHE_MISS: return "move_cache_miss";
+        default: return "unknown";
+    }
+}
+
+const char* phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::GENERATE_MOVES: return "generate_moves";
+        case Phase::LEGAL_MOVE: return "legal_move";
+        default: return "unknown";
+    }
+}
+
+namespace stats {
+    ThreadStats::ThreadStats() {
+        Registry& all = registry();
+        std::lock_guard<std::mutex> lock(all.lock);
+        all.threads.push_back(this);
+    }
+
+    ThreadStats::~ThreadStats() {
+        Registry& all = registry();
+        std::lock_guard<std::mutex> lock(all.lock);
+        all.finished += snapshot();
+        std::erase(all.threads, this);
+    }
+
+    GameStats ThreadStats::snapshot() const {
+        GameStats stats;
+        for (int i = 0; i < static_cast<int>(Counter::COUNT); i++)
+            stats.counters[i] = counters[i].load(std::memory_order_relaxed);
+        for (int i = 0; i < static_cast<int>(Phase::COUNT); i++)
+            stats.nanoseconds[i] = nanoseconds[i].load(std::memory_order_relaxed);
+        stats.legalMoveDepth = legalMoveDepth.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // (a thread counting at the same time may lose what it counts while this runs)
+    void ThreadStats::clear() {
+        for (auto& counter : counters)
+            counter.store(0, std::memory_order_relaxed);
+        for (auto& time : nanoseconds)
+            time.store(0, std::memory_order_relaxed);
+        legalMoveDepth.store(0, std::memory_order_relaxed);
+    }
+
+    GameStats total() {
+        Registry& all = registry();
+        std::lock_guard<std::mutex> lock(all.lock);
+        GameStats sum = all.finished;
+        for (const ThreadStats* thread : all.threads)
+            sum += thread->snapshot();
+        return sum;
+    }
+
+    void reset() {
+        Registry& all = registry();
+        std::lock_guard<std::mutex> lock(all.lock);
+        all.finished = GameStats();
+        for (ThreadStats* thread : all.threads)
+            thread->clear();
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Counters and timers for what a Game spends its time on, so a slow run can be explained
+// without a profiler. They are only compiled in when the build defines CHESS_STATS
+// (cmake -DCHESS_STATS=ON); otherwise CHESS_COUNT() and CHESS_TIME() are nothing and
+// Game::Stats() is all zeros.
+//
+// Every thread counts into its own block, which only it writes, so counting never waits on
+// another thread. Game::Stats() adds up every thread's (including the ones that have finished).
+// With the environment variable CHESS_STATS_JSON set to a file name (or "-" for stderr)
+// the totals are written there as JSON when the program exits.
+
+enum class Counter {
+    LEGAL_MOVE, // LegalMove() calls
+    GET_PIECE, // getPiece() lookups
+    MAKE_MOVE,
+    UNMAKE_MOVE,
+    GENERATE_MOVES, // GenerateMoves() calls
+    HISTORY_SCANS, // repetitions() looking back through the undo stack
+    MOVE_CACHE_HIT, // legalMoves() answered from its cache
+    MOVE_CACHE_MISS,
+    COUNT,
+};
+
+// timed sections
+enum class Phase {
+    GENERATE_MOVES,
+    LEGAL_MOVE,
+    COUNT,
+};
+
+struct GameStats {
+    uint64_t counters[static_cast<int>(Counter::COUNT)] = {};
+    uint64_t nanoseconds[static_cast<int>(Phase::COUNT)] = {};
+    // the deepest LegalMove() calls have nested (1 unless something it calls checks another move)
+    uint64_t legalMoveDepth = 0;
+
+    uint64_t operator[](Counter counter) const { return counters[static_cast<int>(counter)]; }
+    double seconds(Phase phase) const { return nanoseconds[static_cast<int>(phase)] * 1e-9; }
+    GameStats& operator+=(const GameStats& other);
+    // {"counters": {"legal_move": 12, ...}, "seconds": {...}, "legal_move_depth": 2}
+    std::string ToJSON() const;
+};
+
+const char* counterName(Counter counter);
+const char* phaseName(Phase phase);
+
+namespace stats {
+    // One thread's counters. Only that thread writes them, so a plain load and store is enough
+    // (no locked add), they are atomic so that Game::Stats() can read them from another thread.
+    struct ThreadStats {
+        std::atomic<uint64_t> counters[static_cast<int>(Counter::COUNT)] = {};
+        std::atomic<uint64_t> nanoseconds[static_cast<int>(Phase::COUNT)] = {};
+        std::atomic<uint64_t> legalMoveDepth = 0;
+        uint64_t depth = 0; // how deep LegalMove() is right now
+
+        // (un)registers with the list Game::Stats() adds up, see GameStats.cpp
+        ThreadStats();
+        ~ThreadStats();
+        GameStats snapshot() const;
+        void clear();
+    };
+
+    inline ThreadStats& local() {
+        thread_local ThreadStats stats;
+        return stats;
+    }
+
+    inline void add(std::atomic<uint64_t>& value, uint64_t amount) {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    inline void count(Counter counter) { add(local().counters[static_cast<int>(counter)], 1); }
+
+    // adds the time until the end of the scope to a phase
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Phase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer() {
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            add(local().nanoseconds[static_cast<int>(phase)], elapsed.count());
+        }
+
+    private:
+        Phase phase;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // keeps track of how deep LegalMove() is in itself
+    class LegalMoveDepth {
+    public:
+        LegalMoveDepth() {
+            ThreadStats& stats = local();
+            if (++stats.depth > stats.legalMoveDepth.load(std::memory_order_relaxed))
+                stats.legalMoveDepth.store(stats.depth, std::memory_order_relaxed);
+        }
+        ~LegalMoveDepth() { local().depth--; }
+    };
+
+    // every thread's counters added up
+    GameStats total();
+    void reset();
+}
+
+#if defined(CHESS_STATS)
+#define CHESS_COUNT(counter) stats::count(Counter::counter)
+#define CHESS_STATS_CONCAT2(a, b) a##b
+#define CHESS_STATS_CONCAT(a, b) CHESS_STATS_CONCAT2(a, b)
+#define CHESS_TIME(phase) stats::ScopedTimer CHESS_STATS_CONCAT(phaseTimer, __LINE__)(Phase::phase)
+#define CHESS_LEGAL_MOVE_DEPTH() stats::LegalMoveDepth CHESS_STATS_CONCAT(legalMoveDepth, __LINE__)
+#else
+#define CHESS_COUNT(counter) do {} while (0)
+#define CHESS_TIME(phase) do {} while (0)
+#define CHESS_LEGAL_MOVE_DEPTH() do {} while (0)
+#endif
@@ -0,0 +1,62 @@
+#include "MappedFile.h"
+#include <fstream>
+#include <sstream>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CHESS_HAVE_MMAP
+#endif
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+
+#if defined(CHESS_HAVE_MMAP)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0) {
+        size = static_cast<size_t>(info.st_size);
+        // empty files can't be mapped, but there's nothing to read anyway
+        void* mapped = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+        if (size == 0 || mapped != MAP_FAILED) {
+            data = static_cast<const char*>(mapped);
+            this->mapped = data != nullptr;
+            // it is read front to back
+            if (this->mapped)
+                madvise(mapped, size, MADV_SEQUENTIAL);
+            open = true;
+        }
+    }
+    ::close(fd);
+    if (open)
+        return true;
+    size = 0;
+#endif
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    buffer = contents.str();
+    data = buffer.data();
+    size = buffer.size();
+    open = true;
+    return true;
+}
+
+void MappedFile::Close() {
+#if defined(CHESS_HAVE_MMAP)
+    if (mapped)
+        munmap(const_cast<char*>(data), size);
+#endif
+    buffer.clear();
+    mapped = false;
+    data = nullptr;
+    size = 0;
+    open = false;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// A whole file mapped into memory, read-only. The operating system pages it in as it is read,
+// so even huge files cost no more than the pages being looked at.
+// (Where there is no mmap, the file is read into memory instead.)
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    std::string_view text() const { return { data, size }; }
+    bool isOpen() const { return open; }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    bool open = false;
+    bool mapped = false; // by mmap, rather than read into the buffer
+    std::string buffer; // when the file couldn't be mapped
+};
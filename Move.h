@@ -1,6 +1,8 @@
+#pragma once
+#include <cstdint>
 #include <functional>
 
-enum class PieceType {
+enum class PieceType : unsigned char {
     NONE,
     PAWN,
     KNIGHT,
@@ -17,8 +19,16 @@ enum Teams {
     BLACK = 1,
 };
 
+// which way a king castles
+enum class CastleSide : unsigned char {
+    NONE, // not a castle, or a castle that hasn't said which way yet
+    SHORT, // the king goes to the g file, with the h rook
+    LONG, // the king goes to the c file, with the a rook
+};
+
 struct MoveType {
-    bool captures = false, checks = false, promotes = false, castles = false, castleDir = false, enPassant = false; // castleDir: 0 = short 1 = long
+    bool captures = false, checks = false, promotes = false, castles = false, enPassant = false;
+    CastleSide castleSide = CastleSide::NONE;
 
     bool operator==(const MoveType& other) const {
         return
@@ -26,7 +36,7 @@ struct MoveType {
             (checks == other.checks) &&
             (promotes == other.promotes) &&
             (castles == other.castles) && 
-            (castleDir == other.castleDir) &&
+            (castleSide == other.castleSide) &&
             (enPassant == other.enPassant);
     }
 
@@ -98,6 +108,21 @@ struct Move {
     bool operator!=(const Move& other) const { return !(*this == other); }
 };
 
+// Squeezes a Move into 16 bits: from (6 bits), to (6 bits) and promotion (3 bits),
+// squares are numbered y * 8 + x. 0 is never a real move (a1 to a1).
+inline uint16_t packMove(const Move& move) {
+    return static_cast<uint16_t>((move.from.y * 8 + move.from.x)
+        | ((move.to.y * 8 + move.to.x) << 6)
+        | (static_cast<int>(move.promotion) << 12));
+}
+
+inline Move unpackMove(uint16_t packed) {
+    Move move;
+    move.from = { packed & 7, (packed >> 3) & 7 };
+    move.to = { (packed >> 6) & 7, (packed >> 9) & 7 };
+    move.promotion = static_cast<PieceType>((packed >> 12) & 7);
+    return move;
+}
 
 struct AlgebraicMove {
     Square to;
@@ -106,8 +131,26 @@ struct AlgebraicMove {
     PieceType promotion;
 };
 
+// Why LegalMove() turned a move down (NONE when it didn't)
+enum class Rejection : unsigned char {
+    NONE,
+    OFF_BOARD,
+    WRONG_TEAM, // the piece on the from square isn't the team's (or there is none)
+    WRONG_PIECE, // it isn't the type of piece asked for
+    OWN_PIECE, // one of the team's own pieces is on the destination
+    NO_CASTLING_RIGHT, // the king or that rook has moved
+    BAD_PROMOTION, // only pawns promote
+    IMPOSSIBLE, // the piece doesn't move like that
+    PAWN_CAPTURE, // pawns capture if and only if they move sideways
+    PAWN_DOUBLE_STEP, // only from the starting rank
+    BLOCKED, // something is in the way
+    CASTLING_THROUGH_CHECK, // out of, or through, check
+    SELF_CHECK, // it would leave the king in check
+};
+
 struct CompleteMove {
     bool valid = false;
+    Rejection rejection = Rejection::NONE;
     Teams color = Teams::NONE;
 
     Move move;
@@ -130,13 +173,26 @@ struct CompleteMove {
         ret.color = color;
         return ret;
     }
-    
-    CompleteMove operator=(const CompleteMove other) {
-        valid = other.valid;
-        color = other.color;
-        move = other.move;
-        moveType = other.moveType;
-        pieceType = other.pieceType;
-        return (*this);
-    }
+};
+
+// A fixed-capacity list of moves, meant to live on the stack so that
+// generating moves never allocates.
+// No legal chess position has more than 218 moves, so 256 is plenty.
+struct MoveList {
+    static const int capacity = 256;
+
+    CompleteMove moves[capacity];
+    int count = 0;
+
+    void push(const CompleteMove& move) { moves[count++] = move; }
+    void clear() { count = 0; }
+    int size() const { return count; }
+
+    CompleteMove& operator[](int i) { return moves[i]; }
+    const CompleteMove& operator[](int i) const { return moves[i]; }
+
+    CompleteMove* begin() { return moves; }
+    CompleteMove* end() { return moves + count; }
+    const CompleteMove* begin() const { return moves; }
+    const CompleteMove* end() const { return moves + count; }
 };
@@ -0,0 +1,177 @@
+#include "PGN.h"
+
+namespace {
+    bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    // the index of the next line (or the end)
+    size_t nextLine(std::string_view text, size_t i) {
+        size_t end = text.find('\n', i);
+        return end == std::string_view::npos ? text.size() : end + 1;
+    }
+}
+
+std::string_view PGNGame::tag(std::string_view name) const {
+    for (size_t i = 0; i < tags.size(); i = nextLine(tags, i)) {
+        // [Name "value"]
+        size_t open = tags.find('[', i);
+        if (open == std::string_view::npos)
+            break;
+        i = open;
+        if (tags.compare(open + 1, name.size(), name) != 0 || open + 1 + name.size() >= tags.size()
+            || !isSpace(tags[open + 1 + name.size()]))
+            continue;
+
+        size_t quote = tags.find('"', open + 1 + name.size());
+        if (quote == std::string_view::npos)
+            break;
+        size_t end = quote + 1;
+        while (end < tags.size() && tags[end] != '"') {
+            if (tags[end] == '\\')
+                end++;
+            end++;
+        }
+        if (end >= tags.size())
+            break;
+        return tags.substr(quote + 1, end - quote - 1);
+    }
+    return {};
+}
+
+bool PGNReader::Next(PGNGame& game) {
+    while (position < text.size() && isSpace(text[position]))
+        position++;
+    if (position >= text.size())
+        return false;
+
+    // the tag pairs, one per line
+    size_t start = position;
+    while (position < text.size() && text[position] == '[') {
+        position = nextLine(text, position);
+        while (position < text.size() && isSpace(text[position]))
+            position++;
+    }
+    game.tags = text.substr(start, position - start);
+
+    // the moves go on until a line starts with the next game's tags (outside of a comment)
+    start = position;
+    bool lineStart = false;
+    while (position < text.size()) {
+        char c = text[position];
+        if (c == '{') {
+            size_t end = text.find('}', position);
+            position = end == std::string_view::npos ? text.size() : end + 1;
+            lineStart = false;
+            continue;
+        }
+        if (c == ';') {
+            position = nextLine(text, position);
+            lineStart = true;
+            continue;
+        }
+        if (lineStart && c == '[')
+            break;
+        lineStart = c == '\n';
+        position++;
+    }
+    game.movetext = text.substr(start, position - start);
+    return true;
+}
+
+bool MovetextReader::Next(std::string_view& san) {
+    while (position < text.size()) {
+        char c = text[position];
+        if (isSpace(c) || c == ')') {
+            position++;
+            continue;
+        }
+
+        if (c == '{') {
+            size_t end = text.find('}', position);
+            position = end == std::string_view::npos ? text.size() : end + 1;
+            continue;
+        }
+        if (c == ';') {
+            position = nextLine(text, position);
+            continue;
+        }
+        // variations can be nested, and have comments of their own
+        if (c == '(') {
+            int depth = 0;
+            while (position < text.size()) {
+                char v = text[position];
+                if (v == '{') {
+                    size_t end = text.find('}', position);
+                    position = end == std::string_view::npos ? text.size() : end;
+                } else if (v == ';')
+                    position = nextLine(text, position) - 1;
+                else if (v == '(')
+                    depth++;
+                else if (v == ')' && --depth == 0)
+                    break;
+                position++;
+            }
+            position++;
+            continue;
+        }
+
+        // a token runs up to whitespace or the start of a comment or variation
+        size_t start = position;
+        while (position < text.size() && !isSpace(text[position]) && text[position] != '{'
+            && text[position] != '(' && text[position] != ')' && text[position] != ';')
+            position++;
+        std::string_view token = text.substr(start, position - start);
+
+        // NAGs
+        if (token[0] == '$')
+            continue;
+        // the result ends the moves
+        if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+            position = text.size();
+            return false;
+        }
+        // "0-0" is castling, other numbers are move numbers ("12." "12..." or stuck onto the move, "12.e4")
+        if (token[0] >= '0' && token[0] <= '9' && token.substr(0, 3) != "0-0") {
+            size_t skip = 0;
+            while (skip < token.size() && ((token[skip] >= '0' && token[skip] <= '9') || token[skip] == '.'))
+                skip++;
+            token.remove_prefix(skip);
+        }
+        while (!token.empty() && token[0] == '.')
+            token.remove_prefix(1);
+        if (token.empty())
+            continue;
+
+        san = token;
+        return true;
+    }
+    return false;
+}
+
+ReplayResult replayGame(const PGNGame& pgn, Game& game) {
+    ReplayResult result;
+
+    std::string_view fen = pgn.tag("FEN");
+    if (!game.Load(fen.empty() ? START_FEN : fen)) {
+        result.error.status = SANStatus::SYNTAX;
+        result.failed = fen;
+        return result;
+    }
+
+    MovetextReader moves(pgn.movetext);
+    std::string_view san;
+    while (moves.Next(san)) {
+        CompleteMove move;
+        SANMove parsed;
+        if (!parseSAN(san, parsed))
+            result.error.status = SANStatus::SYNTAX;
+        else
+            resolveSAN(game, parsed, move, result.error);
+        if (result.error.status != SANStatus::OK) {
+            result.failed = san;
+            return result;
+        }
+        game.MakeMove(move);
+        result.plies++;
+    }
+    return result;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "Chess.h"
+#include "SAN.h"
+#include <string_view>
+
+// Reading games out of PGN text without copying any of it: games, tags and moves are all
+// views into the text (see MappedFile.h for getting a whole file in memory cheaply).
+
+// One game's text
+struct PGNGame {
+    std::string_view tags; // the [Name "value"] lines
+    std::string_view movetext; // everything after them, up to the next game
+
+    // the value of a tag (escapes left as they are), empty if the game doesn't have it
+    std::string_view tag(std::string_view name) const;
+};
+
+// Splits PGN text into games
+class PGNReader {
+public:
+    explicit PGNReader(std::string_view text) : text(text) {}
+
+    // false at the end of the text
+    bool Next(PGNGame& game);
+
+private:
+    std::string_view text;
+    size_t position = 0;
+};
+
+// Hands out a game's moves one SAN at a time. Comments, variations, NAGs ($1),
+// move numbers and the result are skipped.
+class MovetextReader {
+public:
+    explicit MovetextReader(std::string_view movetext) : text(movetext) {}
+
+    // false once the moves run out
+    bool Next(std::string_view& san);
+
+private:
+    std::string_view text;
+    size_t position = 0;
+};
+
+struct ReplayResult {
+    SANError error; // status SYNTAX for a FEN tag that doesn't parse too
+    int plies = 0; // moves played
+    std::string_view failed; // the move (or FEN) that stopped the replay
+};
+
+// Plays a game from its start (its FEN tag, if it has one) through the move generator.
+// Reuses the Game, so replaying allocates nothing once its undo stack is big enough.
+ReplayResult replayGame(const PGNGame& pgn, Game& game);
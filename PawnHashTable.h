@@ -0,0 +1,58 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Counters for a PawnHashTable
+struct PawnHashStats {
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+
+    double hitRate() const { return probes ? double(hits) / probes : 0; }
+    PawnHashStats& operator+=(const PawnHashStats& other) {
+        probes += other.probes;
+        hits += other.hits;
+        return *this;
+    }
+};
+
+// Remembers the pawn structure score of the last pawn formations seen, by Board::pawnKey.
+// Pawns only move every few plies (and most of the search tree shares a formation), so nearly
+// every lookup hits and the pawn structure is only worked out when pawns actually change.
+// Every Evaluator has its own, so it is never shared between threads. It is worth keeping warm:
+// a Search keeps its Evaluator across SetPosition(), and batch keeps one Search per worker thread.
+class PawnHashTable {
+public:
+    // 2^bits entries, 16 bytes each
+    explicit PawnHashTable(int bits = 14) : entries(size_t(1) << bits), mask((size_t(1) << bits) - 1) {}
+
+    // score is set to the cached score if there is one for these pawns
+    bool Probe(uint64_t key, int& score) {
+        stats.probes++;
+        const Entry& entry = entries[key & mask];
+        if (entry.key != key)
+            return false;
+        stats.hits++;
+        score = entry.score;
+        return true;
+    }
+
+    void Store(uint64_t key, int score) { entries[key & mask] = { key, score }; }
+
+    // (an empty entry looks like a position without pawns, whose score is 0 anyway)
+    void Clear() { std::fill(entries.begin(), entries.end(), Entry()); }
+
+    const PawnHashStats& getStats() const { return stats; }
+    void ResetStats() { stats = PawnHashStats(); }
+
+private:
+    struct Entry {
+        uint64_t key = 0;
+        int score = 0;
+    };
+
+    std::vector<Entry> entries;
+    size_t mask;
+    PawnHashStats stats;
+};
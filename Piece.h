@@ -1,9 +1,10 @@
 #pragma once
 #include "Move.h"
-#include <cmath>
+#include "PieceRules.h"
 
 class Piece {
 public:
+    virtual ~Piece() = default;
     inline virtual PieceType Type() const { return PieceType::NONE; }
     inline virtual bool PossibleMove(const Move&) const { return false; }
 };
@@ -48,84 +49,10 @@ public:
     inline virtual bool PossibleMove(const Move& m) const override;
 };
 
-bool Pawn::PossibleMove(const Move& m) const {
-        // piece cannot move to itself
-        if (m.to == m.from)
-            return false; 
-
-        Square forwardStep;
-        // counter-rotate the offset
-        forwardStep = (m.to - m.from);
-        for (int i = 0; i < direction % 4; i++) {
-            int x = forwardStep.x;
-            forwardStep.x = -forwardStep.y;
-            forwardStep.y = x;
-        }
-
-        if (forwardStep.y == 1)
-            return (abs(forwardStep.x) <= 1);
-        if (forwardStep.y == 2)
-            return (forwardStep.x == 0);
-
-        return false;
-}
-
-bool Knight::PossibleMove(const Move& m) const {
-    // piece cannot move to itself
-    if (m.from == m.to)
-        return false; 
-
-    Square offset = m.to - m.from;
-    if (offset.x == 0 || offset.y == 0)
-        return false; 
-
-    return (abs(offset.x) + abs(offset.y) == 3);
-}
-
-
-bool Bishop::PossibleMove(const Move& m) const {
-    // piece cannot move to itself
-    if (m.from == m.to)
-        return false; 
-
-    Square offset = m.to - m.from;
-    return (abs(offset.x) == abs(offset.y));
-}
-
-
-bool Rook::PossibleMove(const Move& m) const {
-    // piece cannot move to itself
-    if (m.to == m.from)
-        return false; 
-
-    return ((m.to.x == m.from.x) || (m.to.y == m.from.y));
-}
-
-bool Queen::PossibleMove(const Move& m) const {
-    // piece cannot move to itself
-    if (m.to == m.from)
-        return false; 
-
-    // combine logic from both rook & bishop
-    Square offset = m.to - m.from;
-    if (abs(offset.x) == abs(offset.y)) 
-        return true;
-    if ((m.to.x == m.from.x) || (m.to.y == m.from.y))
-        return true;
-
-    return false;
-}
-
-
-bool King::PossibleMove(const Move& m) const {
-    // piece cannot move to itself
-    if (m.to == m.from)
-        return false; 
-
-    if (abs(m.to.x - m.from.x) <= 1 && abs(m.to.y - m.from.y) <= 1)
-        return true;
-    if (abs(m.to.x - m.from.x) <= 1 || abs(m.to.y - m.from.y) <= 1)
-        return true;
-
-    return false;
-}
+// the rules themselves live in PieceRules.h, where the move generator can use them without a Piece
+bool Pawn::PossibleMove(const Move& m) const { return possibleMove<PieceType::PAWN>(m, direction); }
+bool Knight::PossibleMove(const Move& m) const { return possibleMove<PieceType::KNIGHT>(m); }
+bool Bishop::PossibleMove(const Move& m) const { return possibleMove<PieceType::BISHOP>(m); }
+bool Rook::PossibleMove(const Move& m) const { return possibleMove<PieceType::ROOK>(m); }
+bool Queen::PossibleMove(const Move& m) const { return possibleMove<PieceType::QUEEN>(m); }
+bool King::PossibleMove(const Move& m) const { return possibleMove<PieceType::KING>(m); }
@@ -0,0 +1,81 @@
+#pragma once
+#include "Move.h"
+#include "Attacks.h"
+#include <cstdint>
+
+// How each piece moves, picked by PieceType at compile time instead of through Piece's virtual functions.
+// possibleMove() is the shape of a move on an empty board (what Piece::PossibleMove answers),
+// pieceTargets() is every square a piece reaches on a real one.
+
+// how far a pawn's forward step is rotated, in quarter turns: 0 goes up the board, 2 goes down
+// (the same direction as Pawn(direction)).
+constexpr int pawnDirection(Teams color) { return color == Teams::BLACK ? 2 : 0; }
+
+constexpr int distance(int a, int b) { return a > b ? a - b : b - a; }
+
+template <PieceType Type>
+constexpr bool possibleMove(const Move& m, int direction = 0) {
+    // piece cannot move to itself
+    if (m.to == m.from)
+        return false;
+
+    int dx = distance(m.to.x, m.from.x);
+    int dy = distance(m.to.y, m.from.y);
+
+    if constexpr (Type == PieceType::PAWN) {
+        // counter-rotate the offset
+        Square forwardStep = m.to - m.from;
+        for (int i = 0; i < direction % 4; i++) {
+            int x = forwardStep.x;
+            forwardStep.x = -forwardStep.y;
+            forwardStep.y = x;
+        }
+        if (forwardStep.y == 1)
+            return distance(forwardStep.x, 0) <= 1;
+        if (forwardStep.y == 2)
+            return forwardStep.x == 0;
+        return false;
+    } else if constexpr (Type == PieceType::KNIGHT)
+        return dx != 0 && dy != 0 && dx + dy == 3;
+    else if constexpr (Type == PieceType::BISHOP)
+        return dx == dy;
+    else if constexpr (Type == PieceType::ROOK)
+        return dx == 0 || dy == 0;
+    else if constexpr (Type == PieceType::QUEEN)
+        return dx == dy || dx == 0 || dy == 0;
+    else if constexpr (Type == PieceType::KING)
+        // (castling is the king moving onto its rook, anywhere along the rank)
+        return dx <= 1 || dy <= 1;
+    else
+        return false;
+}
+
+// for when the PieceType is only known at run time
+constexpr bool possibleMove(PieceType type, const Move& m, int direction = 0) {
+    switch (type) {
+        case PieceType::PAWN: return possibleMove<PieceType::PAWN>(m, direction);
+        case PieceType::KNIGHT: return possibleMove<PieceType::KNIGHT>(m);
+        case PieceType::BISHOP: return possibleMove<PieceType::BISHOP>(m);
+        case PieceType::ROOK: return possibleMove<PieceType::ROOK>(m);
+        case PieceType::QUEEN: return possibleMove<PieceType::QUEEN>(m);
+        case PieceType::KING: return possibleMove<PieceType::KING>(m);
+        default: return false;
+    }
+}
+
+// the squares a (non-pawn) piece on index attacks, blocked by occupied
+template <PieceType Type>
+inline uint64_t pieceTargets(int index, uint64_t occupied) {
+    if constexpr (Type == PieceType::KNIGHT)
+        return attacks.knight[index];
+    else if constexpr (Type == PieceType::BISHOP)
+        return bishopAttacks(index, occupied);
+    else if constexpr (Type == PieceType::ROOK)
+        return rookAttacks(index, occupied);
+    else if constexpr (Type == PieceType::QUEEN)
+        return queenAttacks(index, occupied);
+    else if constexpr (Type == PieceType::KING)
+        return attacks.king[index];
+    else
+        return 0;
+}
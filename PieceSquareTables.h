@@ -0,0 +1,129 @@
+#pragma once
+#include <cstdint>
+
+// What a piece is worth on each square, once for the middlegame and once for the endgame.
+// The Board adds these up as pieces come and go (like its Zobrist key), and the Evaluator
+// blends the two sums by how much material is left (see Evaluator.h).
+//
+// The tables below are drawn from white's side of the board, rank 8 at the top,
+// and already include the piece's material value. Black's are the same, flipped.
+
+// how much each PieceType counts towards the middlegame, a full board adds up to MAX_PHASE
+constexpr int phaseWeights[7] = { 0, 0, 1, 1, 2, 4, 0 };
+constexpr int MAX_PHASE = 24;
+
+constexpr int middlegameValues[7] = { 0, 82, 337, 365, 477, 1025, 0 };
+constexpr int endgameValues[7] = { 0, 94, 281, 297, 512, 936, 0 };
+
+namespace pst {
+    constexpr int16_t pawnMiddlegame[64] = {
+          0,   0,   0,   0,   0,   0,   0,   0,
+         50,  50,  50,  50,  50,  50,  50,  50,
+         10,  10,  20,  30,  30,  20,  10,  10,
+          5,   5,  10,  25,  25,  10,   5,   5,
+          0,   0,   0,  20,  20,   0,   0,   0,
+          5,  -5, -10,   0,   0, -10,  -5,   5,
+          5,  10,  10, -20, -20,  10,  10,   5,
+          0,   0,   0,   0,   0,   0,   0,   0,
+    };
+    // pawns only need to run in the endgame
+    constexpr int16_t pawnEndgame[64] = {
+          0,   0,   0,   0,   0,   0,   0,   0,
+         80,  80,  80,  80,  80,  80,  80,  80,
+         50,  50,  50,  50,  50,  50,  50,  50,
+         30,  30,  30,  30,  30,  30,  30,  30,
+         15,  15,  15,  15,  15,  15,  15,  15,
+          5,   5,   5,   5,   5,   5,   5,   5,
+          0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,
+    };
+    constexpr int16_t knight[64] = {
+        -50, -40, -30, -30, -30, -30, -40, -50,
+        -40, -20,   0,   0,   0,   0, -20, -40,
+        -30,   0,  10,  15,  15,  10,   0, -30,
+        -30,   5,  15,  20,  20,  15,   5, -30,
+        -30,   0,  15,  20,  20,  15,   0, -30,
+        -30,   5,  10,  15,  15,  10,   5, -30,
+        -40, -20,   0,   5,   5,   0, -20, -40,
+        -50, -40, -30, -30, -30, -30, -40, -50,
+    };
+    constexpr int16_t bishop[64] = {
+        -20, -10, -10, -10, -10, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,  10,  10,   5,   0, -10,
+        -10,   5,   5,  10,  10,   5,   5, -10,
+        -10,   0,  10,  10,  10,  10,   0, -10,
+        -10,  10,  10,  10,  10,  10,  10, -10,
+        -10,   5,   0,   0,   0,   0,   5, -10,
+        -20, -10, -10, -10, -10, -10, -10, -20,
+    };
+    constexpr int16_t rookMiddlegame[64] = {
+          0,   0,   0,   0,   0,   0,   0,   0,
+          5,  10,  10,  10,  10,  10,  10,   5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+          0,   0,   0,   5,   5,   0,   0,   0,
+    };
+    constexpr int16_t rookEndgame[64] = {};
+    constexpr int16_t queen[64] = {
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,   5,   5,   5,   0, -10,
+         -5,   0,   5,   5,   5,   5,   0,  -5,
+          0,   0,   5,   5,   5,   5,   0,  -5,
+        -10,   5,   5,   5,   5,   5,   0, -10,
+        -10,   0,   5,   0,   0,   0,   0, -10,
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+    };
+    // the king hides in the middlegame...
+    constexpr int16_t kingMiddlegame[64] = {
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -20, -30, -30, -40, -40, -30, -30, -20,
+        -10, -20, -20, -20, -20, -20, -20, -10,
+         20,  20,   0,   0,   0,   0,  20,  20,
+         20,  30,  10,   0,   0,  10,  30,  20,
+    };
+    // ...and comes out in the endgame
+    constexpr int16_t kingEndgame[64] = {
+        -50, -40, -30, -20, -20, -30, -40, -50,
+        -30, -20, -10,   0,   0, -10, -20, -30,
+        -30, -10,  20,  30,  30,  20, -10, -30,
+        -30, -10,  30,  40,  40,  30, -10, -30,
+        -30, -10,  30,  40,  40,  30, -10, -30,
+        -30, -10,  20,  30,  30,  20, -10, -30,
+        -30, -30,   0,   0,   0,   0, -30, -30,
+        -50, -30, -30, -30, -30, -30, -30, -50,
+    };
+}
+
+// by team, PieceType and square index (y * 8 + x, see Board.h), material included
+struct PieceSquareTables {
+    int16_t middlegame[2][7][64];
+    int16_t endgame[2][7][64];
+};
+
+constexpr PieceSquareTables makePieceSquareTables() {
+    const int16_t* middlegame[7] = { nullptr, pst::pawnMiddlegame, pst::knight, pst::bishop, pst::rookMiddlegame, pst::queen, pst::kingMiddlegame };
+    const int16_t* endgame[7] = { nullptr, pst::pawnEndgame, pst::knight, pst::bishop, pst::rookEndgame, pst::queen, pst::kingEndgame };
+
+    PieceSquareTables tables = {};
+    for (int type = 1; type < 7; type++) {
+        for (int index = 0; index < 64; index++) {
+            // the drawings start at a8, so white reads them upside down
+            int white = index ^ 56;
+            tables.middlegame[0][type][index] = middlegameValues[type] + middlegame[type][white];
+            tables.endgame[0][type][index] = endgameValues[type] + endgame[type][white];
+            tables.middlegame[1][type][index] = middlegameValues[type] + middlegame[type][index];
+            tables.endgame[1][type][index] = endgameValues[type] + endgame[type][index];
+        }
+    }
+    return tables;
+}
+
+inline constexpr PieceSquareTables pieceSquare = makePieceSquareTables();
@@ -0,0 +1,204 @@
+#include "SAN.h"
+
+namespace {
+    PieceType pieceLetter(char c) {
+        switch (c) {
+            case 'N': return PieceType::KNIGHT;
+            case 'B': return PieceType::BISHOP;
+            case 'R': return PieceType::ROOK;
+            case 'Q': return PieceType::QUEEN;
+            case 'K': return PieceType::KING;
+            default: return PieceType::NONE;
+        }
+    }
+
+    bool isFile(char c) { return c >= 'a' && c <= 'h'; }
+    bool isRank(char c) { return c >= '1' && c <= '8'; }
+}
+
+bool parseSAN(std::string_view text, SANMove& san) {
+    san = SANMove();
+
+    // check, mate and annotations say nothing about which move it is
+    while (!text.empty() && (text.back() == '+' || text.back() == '#' || text.back() == '!' || text.back() == '?'))
+        text.remove_suffix(1);
+    if (text.empty())
+        return false;
+
+    if (text == "O-O" || text == "0-0") {
+        san.castles = true;
+        san.castleSide = CastleSide::SHORT;
+        san.pieceType = PieceType::KING;
+        return true;
+    }
+    if (text == "O-O-O" || text == "0-0-0") {
+        san.castles = true;
+        san.castleSide = CastleSide::LONG;
+        san.pieceType = PieceType::KING;
+        return true;
+    }
+
+    size_t i = 0;
+    san.pieceType = pieceLetter(text[0]);
+    if (san.pieceType != PieceType::NONE)
+        i++;
+    else
+        san.pieceType = PieceType::PAWN;
+
+    // the promotion comes last, "e8=Q" or "e8Q"
+    if (san.pieceType == PieceType::PAWN && text.size() >= 3) {
+        PieceType promotion = pieceLetter(text.back());
+        if (promotion != PieceType::NONE) {
+            if (promotion == PieceType::KING)
+                return false;
+            san.promotion = promotion;
+            text.remove_suffix(1);
+            if (text.back() == '=')
+                text.remove_suffix(1);
+        }
+    }
+
+    // what's left is [from file][from rank][x]<to file><to rank>
+    if (text.size() < i + 2 || !isFile(text[text.size() - 2]) || !isRank(text.back()))
+        return false;
+    san.to = { text[text.size() - 2] - 'a', text.back() - '1' };
+    text.remove_suffix(2);
+
+    if (!text.empty() && text.back() == 'x') {
+        san.captures = true;
+        text.remove_suffix(1);
+    }
+    if (i < text.size() && isFile(text[i]))
+        san.fromFile = text[i++] - 'a';
+    if (i < text.size() && isRank(text[i]))
+        san.fromRank = text[i++] - '1';
+    if (i != text.size())
+        return false;
+
+    // pawns only say where they come from when they capture, and then always the file
+    if (san.pieceType == PieceType::PAWN) {
+        if (san.captures != (san.fromFile >= 0) || san.fromRank >= 0)
+            return false;
+        if ((san.to.y == 0 || san.to.y == 7) != (san.promotion != PieceType::NONE))
+            return false;
+    }
+    return true;
+}
+
+namespace {
+    const Bitboard fileA = 0x0101010101010101ULL;
+    const Bitboard rank1 = 0xffULL;
+
+    // the squares a pawn moving (not capturing) to index could come from
+    Bitboard pawnPushers(const Board& board, int index, Teams color) {
+        int back = color == Teams::WHITE ? -8 : 8;
+        int one = index + back;
+        if (one < 0 || one > 63 || board.typeAt(index) != PieceType::NONE)
+            return 0;
+        if (board.typeAt(one) != PieceType::NONE)
+            return squareBit(one);
+        // a double step lands on the fourth rank from its side
+        int doubleRank = color == Teams::WHITE ? 3 : 4;
+        return (index >> 3) == doubleRank ? squareBit(one + back) : 0;
+    }
+}
+
+SANStatus resolveSAN(const Game& game, const SANMove& san, CompleteMove& move, SANError& error) {
+    error = SANError();
+    const Board& board = game.getBoard();
+    Teams us = game.getToMove();
+
+    // castles are the king "capturing" its own rook, LegalMove knows the rest
+    if (san.castles) {
+        Square king = game.getKing(us);
+        Square rook = { san.castleSide == CastleSide::SHORT ? 7 : 0, king.y };
+        error.reaching = board.piecesOf(us, PieceType::KING);
+        CompleteMove legal = game.LegalMove({ king, rook }, us, PieceType::KING);
+        if (!legal.valid || !legal.moveType.castles) {
+            error.status = SANStatus::ILLEGAL;
+            return error.status;
+        }
+        error.legal = error.reaching;
+        move = legal;
+        return SANStatus::OK;
+    }
+
+    if (!game.inBounds(san.to)) {
+        error.status = SANStatus::ILLEGAL;
+        return error.status;
+    }
+    int to = squareIndex(san.to);
+    // what stands on the destination: nothing, or an enemy piece (or the pawn an en passant captures)
+    Teams standing = board.teamAt(to);
+    bool enPassant = san.pieceType == PieceType::PAWN && san.fromFile >= 0 && to == game.getEnPassant();
+    if (standing == us || (san.pieceType == PieceType::PAWN && san.fromFile >= 0 && standing == Teams::NONE && !enPassant)) {
+        error.status = SANStatus::ILLEGAL;
+        return error.status;
+    }
+
+    Bitboard from;
+    if (san.pieceType == PieceType::PAWN && san.fromFile < 0)
+        from = pawnPushers(board, to, us) & board.piecesOf(us, PieceType::PAWN);
+    else
+        from = board.attackersOf(to, san.pieceType, us);
+    if (san.fromFile >= 0)
+        from &= fileA << san.fromFile;
+    if (san.fromRank >= 0)
+        from &= rank1 << (8 * san.fromRank);
+    error.reaching = from;
+
+    // every one of them can get there, all that's left is whether it leaves the king in check.
+    // Nearly always there's one, the others are only there for disambiguation (or pinned)
+    CompleteMove candidate;
+    candidate.valid = true;
+    candidate.color = us;
+    candidate.pieceType = san.pieceType;
+    candidate.move.to = san.to;
+    candidate.move.promotion = san.promotion;
+    // the same flags the move generator sets (it leaves checks alone too), so the moves compare equal
+    candidate.moveType.promotes = san.promotion != PieceType::NONE;
+    candidate.moveType.captures = standing != Teams::NONE || enPassant;
+    candidate.moveType.enPassant = enPassant;
+    while (from) {
+        int index = popSquare(from);
+        candidate.move.from = indexSquare(index);
+        if (game.isKingSafeAfter(candidate)) {
+            move = candidate;
+            error.legal |= squareBit(index);
+        }
+    }
+
+    if (error.legal == 0)
+        error.status = SANStatus::ILLEGAL;
+    else if (std::popcount(error.legal) > 1)
+        error.status = SANStatus::AMBIGUOUS;
+    return error.status;
+}
+
+SANStatus resolveSAN(const Game& game, const SANMove& san, CompleteMove& move) {
+    SANError error;
+    return resolveSAN(game, san, move, error);
+}
+
+std::string describe(const SANError& error) {
+    switch (error.status) {
+        case SANStatus::OK: return "ok";
+        case SANStatus::SYNTAX: return "not SAN";
+        case SANStatus::ILLEGAL:
+            return error.reaching ? "illegal, the piece that gets there can't move" : "illegal, nothing gets there";
+        case SANStatus::AMBIGUOUS: break;
+    }
+
+    std::string text = "ambiguous,";
+    Bitboard legal = error.legal;
+    while (legal)
+        text += " " + squareName(indexSquare(popSquare(legal)));
+    return text + " can all move there";
+}
+
+SANStatus resolveSAN(const Game& game, std::string_view text, CompleteMove& move) {
+    SANMove san;
+    if (!parseSAN(text, san))
+        return SANStatus::SYNTAX;
+    return resolveSAN(game, san, move);
+}
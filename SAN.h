@@ -0,0 +1,49 @@
+#pragma once
+#include "Chess.h"
+#include <string>
+#include <string_view>
+
+// Standard Algebraic Notation: "e4", "Nbd2", "exd5", "R1a3", "e8=Q+", "O-O-O".
+// Parsing only looks at the text, resolving finds the one legal move it means in a Game.
+
+// What a SAN move says, before it is matched against a position
+struct SANMove {
+    PieceType pieceType = PieceType::NONE;
+    Square to = { -1, -1 };
+    // disambiguation, -1 when not given
+    int fromFile = -1;
+    int fromRank = -1;
+    PieceType promotion = PieceType::NONE;
+    bool captures = false;
+    bool castles = false;
+    CastleSide castleSide = CastleSide::NONE;
+};
+
+enum class SANStatus {
+    OK,
+    SYNTAX, // not SAN
+    ILLEGAL, // no legal move matches
+    AMBIGUOUS, // more than one legal move matches
+};
+
+// Why a SAN move didn't resolve, and which pieces were in the running
+struct SANError {
+    SANStatus status = SANStatus::OK;
+    // squares of the team's pieces of the right type that reach the square (and match the disambiguation)...
+    Bitboard reaching = 0;
+    // ...and of those that can legally make the move: none when ILLEGAL, two or more when AMBIGUOUS
+    Bitboard legal = 0;
+};
+
+// "ambiguous, b1 f3 can all move there"
+std::string describe(const SANError& error);
+
+// Check, mate and annotation marks ("+", "#", "!?") are allowed and ignored,
+// so are "0-0" castles and promotions without the '='.
+bool parseSAN(std::string_view text, SANMove& san);
+
+// Finds the legal move for the team to move, never allocating.
+// Only the pieces that attack the destination (see Board::attackersOf) are tried, not every legal move.
+SANStatus resolveSAN(const Game& game, const SANMove& san, CompleteMove& move, SANError& error);
+SANStatus resolveSAN(const Game& game, const SANMove& san, CompleteMove& move);
+SANStatus resolveSAN(const Game& game, std::string_view text, CompleteMove& move);
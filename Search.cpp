@@ -0,0 +1,342 @@
+#include "Search.h"
+#include <thread>
+
+namespace {
+    // centipawn value of each PieceType, by index (for ordering captures)
+    const int pieceValues[7] = { 0, 100, 320, 330, 500, 900, 0 };
+
+    bool sameMove(const CompleteMove& a, const CompleteMove& b) {
+        return a.move == b.move && a.color == b.color;
+    }
+
+    // mates are stored as distance from the stored position instead of from the root
+    int scoreToTable(int score, int ply) {
+        if (Search::isMate(score))
+            return score > 0 ? score + ply : score - ply;
+        return score;
+    }
+
+    int scoreFromTable(int score, int ply) {
+        if (Search::isMate(score))
+            return score > 0 ? score - ply : score + ply;
+        return score;
+    }
+}
+
+Search::Search(const Game& game) 
+    : game(game), root(game.getToMove()), ownTable(new TranspositionTable(16)), tt(*ownTable) {}
+
+Search::Search(const Game& game, TranspositionTable& table, int helper) 
+    : game(game), root(game.getToMove()), helper(helper), tt(table) {}
+
+void Search::SetPosition(const Game& game) {
+    this->game = game;
+    root = game.getToMove();
+    stopped = false;
+    for (auto& plyKillers : killers)
+        plyKillers[0] = plyKillers[1] = CompleteMove();
+}
+
+SearchResult Search::Run(const SearchLimits& limits) {
+    this->limits = limits;
+    start = std::chrono::steady_clock::now();
+    nodes = 0;
+    publishedNodes = 0;
+    previousPvLength = 0;
+    ttStats = TTStats();
+    evaluator.ResetStats();
+    if (ownTable)
+        tt.NewSearch();
+
+    SearchResult result;
+    MoveList rootMoves;
+    game.GenerateMoves(root, rootMoves);
+    if (rootMoves.size() == 0)
+        return result;
+
+    // there is always something to play, even if the first iteration gets cut off
+    result.bestMove = rootMoves[0];
+    result.pv = { rootMoves[0] };
+
+    int maxDepth = std::min(limits.depth > 0 ? limits.depth : MAX_PLY - 1, MAX_PLY - 1);
+    // every other helper skips the first iteration, so they don't all search the same tree in lockstep
+    for (int depth = 1 + helper % 2; depth <= maxDepth; depth++) {
+        int score = Negamax(depth, 0, -INFINITE_SCORE, INFINITE_SCORE);
+
+        // a depth that got cut off can't be trusted (unless it is the first, and found something)
+        if (stopped && (depth > 1 || pvLength[0] == 0))
+            break;
+
+        result.score = score;
+        result.depth = depth;
+        result.pv.assign(pv[0], pv[0] + pvLength[0]);
+        std::copy(pv[0], pv[0] + pvLength[0], previousPv);
+        previousPvLength = pvLength[0];
+        if (!result.pv.empty())
+            result.bestMove = result.pv[0];
+
+        if (report) {
+            result.nodes = nodes;
+            result.tt = ttStats;
+            result.pawns = evaluator.pawnStats();
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            report(result);
+        }
+
+        // no point looking deeper once a mate is found
+        if (stopped || isMate(score))
+            break;
+    }
+
+    result.nodes = nodes;
+    result.tt = ttStats;
+    result.pawns = evaluator.pawnStats();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+bool Search::outOfTime() {
+    // the clock is only read every so often, it is slower than a node
+    if ((nodes & 1023) == 0) {
+        publishedNodes.store(nodes, std::memory_order_relaxed);
+        if (limits.movetime > 0) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            if (std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() >= limits.movetime)
+                stopped = true;
+        }
+    }
+    if (limits.nodes > 0 && nodes >= limits.nodes)
+        stopped = true;
+    return stopped;
+}
+
+int Search::Negamax(int depth, int ply, int alpha, int beta) {
+    pvLength[ply] = 0;
+    if (outOfTime())
+        return 0;
+
+    Teams color = game.getToMove();
+    bool inCheck = game.isChecked(color);
+
+    if (ply > 0) {
+        // repeating a position or the fifty-move rule is a draw
+        if (game.repetitions() > 0 || game.getHalfmoveClock() >= 100)
+            return 0;
+        if (ply >= MAX_PLY - 1)
+            return evaluator.Evaluate(game);
+    }
+
+    // check extension: never stop searching while in check
+    if (inCheck)
+        depth++;
+
+    if (depth <= 0)
+        return Quiescence(ply, alpha, beta);
+
+    nodes++;
+
+    // a deep enough result for this position may already be known
+    uint64_t key = game.getKey();
+    TTEntry entry;
+    uint16_t ttMove = 0;
+    if (tt.Probe(key, entry, ttStats)) {
+        ttMove = entry.move;
+        int score = scoreFromTable(entry.score, ply);
+        if (ply > 0 && entry.depth >= depth) {
+            // an exact score inside an open window would become part of the PV, with no moves after it,
+            // so those positions are searched again to keep the PV whole
+            bool pvNode = beta - alpha > 1;
+            if (entry.bound == Bound::EXACT && (!pvNode || score <= alpha || score >= beta))
+                return std::clamp(score, alpha, beta);
+            if (entry.bound == Bound::LOWER && score >= beta)
+                return beta;
+            if (entry.bound == Bound::UPPER && score <= alpha)
+                return alpha;
+        }
+    }
+
+    MoveList moves;
+    game.GenerateMoves(color, moves);
+    if (moves.size() == 0)
+        return inCheck ? -MATE + ply : 0;
+
+    OrderMoves(moves, ply, true, ttMove);
+
+    int originalAlpha = alpha;
+
+    for (const auto& move : moves) {
+        game.MakeMove(move);
+        int score = -Negamax(depth - 1, ply + 1, -beta, -alpha);
+        game.UnmakeMove();
+
+        if (stopped)
+            return 0;
+
+        if (score > alpha) {
+            alpha = score;
+
+            // the best line is this move followed by the best line after it
+            pv[ply][0] = move;
+            for (int i = 0; i < pvLength[ply + 1]; i++)
+                pv[ply][i + 1] = pv[ply + 1][i];
+            pvLength[ply] = pvLength[ply + 1] + 1;
+
+            if (score >= beta) {
+                if (!move.moveType.captures && !sameMove(move, killers[ply][0])) {
+                    killers[ply][1] = killers[ply][0];
+                    killers[ply][0] = move;
+                }
+                tt.Store(key, { packMove(move.move), static_cast<int16_t>(scoreToTable(beta, ply)),
+                    static_cast<uint8_t>(depth), Bound::LOWER }, ttStats);
+                return beta;
+            }
+        }
+    }
+
+    if (alpha > originalAlpha)
+        tt.Store(key, { packMove(pv[ply][0].move), static_cast<int16_t>(scoreToTable(alpha, ply)),
+            static_cast<uint8_t>(depth), Bound::EXACT }, ttStats);
+    else
+        tt.Store(key, { 0, static_cast<int16_t>(scoreToTable(alpha, ply)), static_cast<uint8_t>(depth), Bound::UPPER }, ttStats);
+    return alpha;
+}
+
+// Only captures (and promotions) are searched until the position is quiet,
+// so the evaluation never happens in the middle of an exchange.
+int Search::Quiescence(int ply, int alpha, int beta) {
+    pvLength[ply] = 0;
+    if (outOfTime())
+        return 0;
+    nodes++;
+
+    Teams color = game.getToMove();
+    bool inCheck = game.isChecked(color);
+
+    MoveList moves;
+    game.GenerateMoves(color, moves);
+    if (moves.size() == 0)
+        return inCheck ? -MATE + ply : 0;
+
+    if (ply >= MAX_PLY - 1)
+        return evaluator.Evaluate(game);
+
+    // the team to move can usually do at least as well as standing still (unless it's in check)
+    if (!inCheck) {
+        int standPat = evaluator.Evaluate(game);
+        if (standPat >= beta)
+            return beta;
+        if (standPat > alpha)
+            alpha = standPat;
+
+        int tactical = 0;
+        for (const auto& move : moves) {
+            if (move.moveType.captures || move.move.promotion != PieceType::NONE)
+                moves[tactical++] = move;
+        }
+        moves.count = tactical;
+    }
+
+    OrderMoves(moves, ply, false);
+
+    for (const auto& move : moves) {
+        game.MakeMove(move);
+        int score = -Quiescence(ply + 1, -beta, -alpha);
+        game.UnmakeMove();
+
+        if (stopped)
+            return 0;
+
+        if (score > alpha) {
+            alpha = score;
+            if (score >= beta)
+                return beta;
+        }
+    }
+    return alpha;
+}
+
+void Search::OrderMoves(MoveList& moves, int ply, bool followPv, uint16_t ttMove) const {
+    const Board& board = game.getBoard();
+    int scores[MoveList::capacity];
+
+    for (int i = 0; i < moves.size(); i++) {
+        const CompleteMove& move = moves[i];
+        int score = 0;
+
+        if (ttMove != 0 && packMove(move.move) == ttMove)
+            score = 2000000;
+        else if (followPv && ply < previousPvLength && sameMove(move, previousPv[ply]))
+            score = 1000000;
+        else if (move.moveType.captures) {
+            // most valuable victim, least valuable attacker
+            PieceType victim = move.moveType.enPassant ? PieceType::PAWN : board.typeAt(squareIndex(move.move.to));
+            score = 100000 + pieceValues[static_cast<int>(victim)] * 10 - pieceValues[static_cast<int>(move.pieceType)] / 10;
+        } else if (sameMove(move, killers[ply][0]))
+            score = 90000;
+        else if (sameMove(move, killers[ply][1]))
+            score = 80000;
+
+        if (move.move.promotion != PieceType::NONE)
+            score += pieceValues[static_cast<int>(move.move.promotion)] * 10;
+        scores[i] = score;
+    }
+
+    // insertion sort, move lists are short
+    for (int i = 1; i < moves.size(); i++) {
+        CompleteMove move = moves[i];
+        int score = scores[i];
+        int j = i - 1;
+        for (; j >= 0 && scores[j] < score; j--) {
+            moves[j + 1] = moves[j];
+            scores[j + 1] = scores[j];
+        }
+        moves[j + 1] = move;
+        scores[j + 1] = score;
+    }
+}
+
+ParallelSearch::ParallelSearch(const Game& game, TranspositionTable& table, int threads) : tt(table) {
+    for (int i = 0; i < std::max(threads, 1); i++)
+        searches.emplace_back(new Search(game, table, i));
+}
+
+SearchResult ParallelSearch::Run(const SearchLimits& limits) {
+    tt.NewSearch();
+
+    // the helpers only stop when told to
+    SearchLimits helperLimits;
+    helperLimits.depth = limits.depth;
+
+    std::vector<std::thread> helpers;
+    std::vector<SearchResult> helperResults(searches.size());
+    for (size_t i = 1; i < searches.size(); i++)
+        helpers.emplace_back([&, i] { helperResults[i] = searches[i]->Run(helperLimits); });
+
+    SearchResult result = searches[0]->Run(limits);
+
+    for (size_t i = 1; i < searches.size(); i++)
+        searches[i]->Stop();
+    for (auto& thread : helpers)
+        thread.join();
+
+    for (size_t i = 1; i < searches.size(); i++) {
+        result.nodes += helperResults[i].nodes;
+        result.tt += helperResults[i].tt;
+        result.pawns += helperResults[i].pawns;
+    }
+    return result;
+}
+
+void ParallelSearch::OnIteration(std::function<void(const SearchResult&)> report) {
+    searches[0]->OnIteration([this, report](const SearchResult& result) {
+        SearchResult total = result;
+        for (size_t i = 1; i < searches.size(); i++)
+            total.nodes += searches[i]->nodeCount();
+        report(total);
+    });
+}
+
+void ParallelSearch::Stop() {
+    for (auto& search : searches)
+        search->Stop();
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "Chess.h"
+#include "Evaluator.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// What stops a search, whichever comes first. 0 means no limit.
+struct SearchLimits {
+    int depth = 64;
+    uint64_t nodes = 0;
+    int64_t movetime = 0; // milliseconds
+};
+
+struct SearchResult {
+    CompleteMove bestMove;
+    std::vector<CompleteMove> pv; // principal variation, starting with bestMove
+    int score = 0; // centipawns for the team to move (see Search::isMate for mates)
+    int depth = 0; // last fully searched depth
+    uint64_t nodes = 0;
+    double seconds = 0;
+    TTStats tt;
+    PawnHashStats pawns;
+};
+
+// Chooses a move for the team to move in a Game.
+// Iterative deepening negamax with alpha-beta, a quiescence search over captures
+// and check extensions, playing on its own copy of the Game with MakeMove/UnmakeMove.
+class Search {
+public:
+    static const int MAX_PLY = 128;
+    static const int INFINITE_SCORE = 32001;
+    static const int MATE = 32000;
+
+    // scores this close to MATE are mates, MATE - score is the number of plies to the mate
+    static bool isMate(int score) { return abs(score) >= MATE - MAX_PLY; }
+
+    // searches with its own (16 MB) transposition table
+    explicit Search(const Game& game);
+    // searches with a table that outlives it, and may be shared with other searches.
+    // Whoever owns the table calls its NewSearch() before every search.
+    // helper searches (see ParallelSearch) start at a later depth, so the threads spread out.
+    Search(const Game& game, TranspositionTable& table, int helper = 0);
+
+    SearchResult Run(const SearchLimits& limits);
+    // may be called from another thread (even before Run), the search returns its last finished depth.
+    // A stopped Search stays stopped until SetPosition().
+    void Stop() { stopped = true; }
+
+    // Searches another position next, without making a new Search (which is a few hundred KB
+    // with its evaluator's pawn table). What the last search learnt about ordering moves is
+    // forgotten, so the result doesn't depend on what was searched before; the pawn table is kept,
+    // its scores only depend on the pawns. The transposition table is its owner's to clear.
+    void SetPosition(const Game& game);
+
+    // called after every finished depth with the result so far (for UCI's info lines), on the searching thread
+    void OnIteration(std::function<void(const SearchResult&)> report) { this->report = std::move(report); }
+    // nodes searched so far, safe to read from another thread (it lags behind by up to 1024 nodes)
+    uint64_t nodeCount() const { return publishedNodes.load(std::memory_order_relaxed); }
+
+private:
+    Game game;
+    Teams root;
+    int helper = 0;
+    Evaluator evaluator;
+
+    std::unique_ptr<TranspositionTable> ownTable;
+    TranspositionTable& tt;
+    TTStats ttStats;
+
+    SearchLimits limits;
+    std::chrono::steady_clock::time_point start;
+    std::atomic<bool> stopped = false;
+    uint64_t nodes = 0;
+    std::atomic<uint64_t> publishedNodes = 0;
+    std::function<void(const SearchResult&)> report;
+
+    // triangular principal variation table, pv[ply] is the best line found from that ply
+    CompleteMove pv[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY] = {};
+    // the last finished iteration's line, searched first in the next one
+    CompleteMove previousPv[MAX_PLY];
+    int previousPvLength = 0;
+    // quiet moves that caused a beta cutoff, tried early at the same ply
+    CompleteMove killers[MAX_PLY][2];
+
+    int Negamax(int depth, int ply, int alpha, int beta);
+    int Quiescence(int ply, int alpha, int beta);
+
+    // orders moves best-first: the table's move, the previous iteration's pv move,
+    // captures by MVV-LVA, killers
+    void OrderMoves(MoveList& moves, int ply, bool followPv, uint16_t ttMove = 0) const;
+    bool outOfTime();
+};
+
+// Lazy SMP: every thread runs its own Search on its own copy of the Game, and they
+// only cooperate through the shared transposition table, where each thread finds
+// what the others already searched. The calling thread's search is the one that counts,
+// the helpers are stopped once it is done.
+class ParallelSearch {
+public:
+    ParallelSearch(const Game& game, TranspositionTable& table, int threads);
+
+    // nodes (and the table counters) are summed over all the threads
+    SearchResult Run(const SearchLimits& limits);
+    void Stop();
+    // reports every depth the calling thread's search finishes, with the nodes of all the threads
+    void OnIteration(std::function<void(const SearchResult&)> report);
+
+private:
+    TranspositionTable& tt;
+    std::vector<std::unique_ptr<Search>> searches;
+};
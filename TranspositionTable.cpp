@@ -0,0 +1,119 @@
+#include "TranspositionTable.h"
+#include <algorithm>
+
+namespace {
+    // an entry and its age squeezed into one word
+    uint64_t pack(const TTEntry& entry, uint8_t age) {
+        return uint64_t(entry.move)
+            | (uint64_t(static_cast<uint16_t>(entry.score)) << 16)
+            | (uint64_t(entry.depth) << 32)
+            | (uint64_t(static_cast<uint8_t>(entry.bound)) << 40)
+            | (uint64_t(age) << 42);
+    }
+
+    TTEntry unpack(uint64_t data) {
+        TTEntry entry;
+        entry.move = static_cast<uint16_t>(data);
+        entry.score = static_cast<int16_t>(static_cast<uint16_t>(data >> 16));
+        entry.depth = static_cast<uint8_t>(data >> 32);
+        entry.bound = static_cast<Bound>((data >> 40) & 3);
+        return entry;
+    }
+
+    uint8_t ageOf(uint64_t data) { return (data >> 42) & 63; }
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    Resize(megabytes);
+}
+
+void TranspositionTable::Resize(size_t megabytes) {
+    // round down to a power of two number of buckets, so a key is turned into an index with a mask
+    size_t wanted = std::max<size_t>(megabytes, 1) * 1024 * 1024 / sizeof(Bucket);
+    size_t count = 1;
+    while (count * 2 <= wanted)
+        count *= 2;
+
+    buckets.reset(new Bucket[count]);
+    bucketCount = count;
+    mask = count - 1;
+    age = 0;
+}
+
+void TranspositionTable::Clear() {
+    for (size_t i = 0; i < bucketCount; i++) {
+        for (Slot& slot : buckets[i].slots) {
+            slot.check.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    age = 0;
+}
+
+bool TranspositionTable::Probe(uint64_t key, TTEntry& entry, TTStats& stats) const {
+    stats.probes++;
+    for (const Slot& slot : bucketFor(key).slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if ((slot.check.load(std::memory_order_relaxed) ^ data) == key && data != 0) {
+            entry = unpack(data);
+            stats.hits++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::Store(uint64_t key, const TTEntry& entry, TTStats& stats) {
+    stats.stores++;
+    Bucket& bucket = bucketFor(key);
+
+    // the same position gets overwritten, otherwise the shallowest and oldest entry goes
+    Slot* replace = nullptr;
+    int worst = 1 << 30;
+    uint64_t replacedData = 0;
+    bool samePosition = false;
+    for (Slot& slot : bucket.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if ((slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+            replace = &slot;
+            replacedData = data;
+            samePosition = true;
+            break;
+        }
+
+        int staleness = (age - ageOf(data)) & 63;
+        int value = static_cast<int>(unpack(data).depth) - 8 * staleness;
+        if (data == 0)
+            value = -(1 << 20);
+        if (value < worst) {
+            worst = value;
+            replace = &slot;
+            replacedData = data;
+        }
+    }
+
+    if (!samePosition && replacedData != 0 && ageOf(replacedData) == age)
+        stats.collisions++;
+
+    TTEntry stored = entry;
+    // keep the old best move if the new search didn't find one
+    if (stored.move == 0 && samePosition)
+        stored.move = unpack(replacedData).move;
+
+    uint64_t data = pack(stored, age);
+    replace->data.store(data, std::memory_order_relaxed);
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    int used = 0;
+    size_t sample = std::min<size_t>(bucketCount, 250);
+    for (size_t i = 0; i < sample; i++) {
+        for (const Slot& slot : buckets[i].slots) {
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if (data != 0 && ageOf(data) == age)
+                used++;
+        }
+    }
+    return static_cast<int>(used * 1000 / (sample * 4));
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// How a stored score relates to the real one
+enum class Bound : unsigned char {
+    NONE,
+    UPPER, // the real score is at most this (no move raised alpha)
+    LOWER, // the real score is at least this (a move failed high)
+    EXACT,
+};
+
+// What the table remembers about a position
+struct TTEntry {
+    uint16_t move = 0; // packMove() of the best move, 0 if none
+    int16_t score = 0;
+    uint8_t depth = 0;
+    Bound bound = Bound::NONE;
+};
+
+// Table counters, kept by each searching thread so they never fight over a cache line
+struct TTStats {
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+    uint64_t stores = 0;
+    uint64_t collisions = 0; // stores that threw out a different position from this search
+
+    uint64_t misses() const { return probes - hits; }
+    TTStats& operator+=(const TTStats& other) {
+        probes += other.probes;
+        hits += other.hits;
+        stores += other.stores;
+        collisions += other.collisions;
+        return *this;
+    }
+};
+
+// A fixed-size cache of searched positions, shared between search threads without locks.
+//
+// Every slot is two 64-bit words: the entry's data, and the position's key XORed with that data.
+// A reader only trusts a slot whose words XOR back to the key it is looking for, so a slot
+// that another thread was halfway through writing just looks like a miss.
+// Slots come in buckets of four that fill exactly one cache line.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes = 16);
+
+    // throws away everything and makes room for (at most) this many megabytes
+    void Resize(size_t megabytes);
+    void Clear();
+    // call before every search, so older entries are replaced first
+    void NewSearch() { age = (age + 1) & 63; }
+
+    bool Probe(uint64_t key, TTEntry& entry, TTStats& stats) const;
+    void Store(uint64_t key, const TTEntry& entry, TTStats& stats);
+
+    // how full the table is in permille, from a sample of it (for UCI's hashfull)
+    int hashfull() const;
+    size_t megabytes() const { return bucketCount * sizeof(Bucket) / (1024 * 1024); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Bucket {
+        Slot slots[4];
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucketCount = 0; // a power of two
+    uint64_t mask = 0; // bucketCount - 1
+    uint8_t age = 0;
+
+    const Bucket& bucketFor(uint64_t key) const { return buckets[key & mask]; }
+    Bucket& bucketFor(uint64_t key) { return buckets[key & mask]; }
+};
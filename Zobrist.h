@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+
+// Zobrist hashing: every (team, piece, square), castling rights combination,
+// en passant file and the side to move get a random 64-bit number, and a position's
+// key is all of its numbers XORed together. Moving a piece is then two XORs.
+struct ZobristKeys {
+    uint64_t pieces[2][7][64];
+    uint64_t castling[16];
+    uint64_t enPassant[8];
+    uint64_t blackToMove;
+};
+
+// splitmix64, good enough random numbers that can be made at compile time
+constexpr uint64_t zobristRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys() {
+    ZobristKeys keys = {};
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+
+    for (auto& team : keys.pieces)
+        for (auto& type : team)
+            for (auto& square : type)
+                square = zobristRandom(state);
+
+    // no castling rights hashes to nothing, so positions without any don't depend on it
+    for (int i = 1; i < 16; i++)
+        keys.castling[i] = zobristRandom(state);
+    for (auto& file : keys.enPassant)
+        file = zobristRandom(state);
+    keys.blackToMove = zobristRandom(state);
+    return keys;
+}
+
+inline constexpr ZobristKeys zobrist = makeZobristKeys();
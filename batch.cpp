@@ -0,0 +1,271 @@
+#include "Chess.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs every position of a FEN/EPD file through the engine on all cores.
+//
+// usage:
+//   batch [--threads n] [--depth d | --perft d] [input [output]]
+//
+// Input is one position per line, stdin and stdout by default. Lines are read as EPD: the board, side,
+// castling and en passant fields, then operations (so a FEN's clocks are just ignored).
+// Every line gets one tab separated line of output, in the order of the input:
+//   search (default depth 4):  position, legal move count, best move, score (centipawns, or #n for mate in n)
+//   perft:                     position, legal move count, nodes, and 'ok'/'FAIL' against the line's
+//                              EPD "D<depth> <nodes>" operation if it has one
+//
+// Lines are handed out to the workers in chunks, and only so many chunks are ever in flight,
+// so memory stays the same whatever the size of the input.
+
+using namespace std;
+
+struct Options {
+    int threads = max(1u, thread::hardware_concurrency());
+    int depth = 4;
+    bool perft = false;
+};
+
+struct Chunk {
+    size_t index = 0;
+    vector<string> lines;
+};
+
+// everything between the reader, the workers and the writer
+class Pipeline {
+public:
+    static const size_t chunkLines = 256;
+
+    explicit Pipeline(int threads) : maxInFlight(threads * 4) {}
+
+    // blocks while too many chunks are being worked on, writing out the finished ones meanwhile
+    void Push(Chunk chunk, ostream& out) {
+        unique_lock<mutex> lock(mutex_);
+        while (pushed - written >= maxInFlight) {
+            if (!WriteFinished(lock, out))
+                chunkDone.wait(lock);
+        }
+        chunk.index = pushed++;
+        todo.push_back(move(chunk));
+        workReady.notify_one();
+    }
+
+    // the input has ended, waits for (and writes) everything still in flight
+    void Finish(ostream& out) {
+        unique_lock<mutex> lock(mutex_);
+        closed = true;
+        workReady.notify_all();
+        while (written < pushed) {
+            if (!WriteFinished(lock, out))
+                chunkDone.wait(lock);
+        }
+    }
+
+    // false once the input has ended and nothing is left to do
+    bool Pop(Chunk& chunk) {
+        unique_lock<mutex> lock(mutex_);
+        workReady.wait(lock, [&] { return !todo.empty() || closed; });
+        if (todo.empty())
+            return false;
+        chunk = move(todo.front());
+        todo.pop_front();
+        return true;
+    }
+
+    void Done(size_t index, string output) {
+        lock_guard<mutex> lock(mutex_);
+        finished[index] = move(output);
+        chunkDone.notify_all();
+    }
+
+private:
+    mutex mutex_;
+    condition_variable workReady, chunkDone;
+    deque<Chunk> todo;
+    // finished chunks waiting for the ones before them
+    map<size_t, string> finished;
+    size_t maxInFlight;
+    size_t pushed = 0, written = 0;
+    bool closed = false;
+
+    // writes out the next finished chunks in order (without holding the lock), returns whether there were any
+    bool WriteFinished(unique_lock<mutex>& lock, ostream& out) {
+        bool any = false;
+        auto next = finished.find(written);
+        while (next != finished.end()) {
+            string output = move(next->second);
+            finished.erase(next);
+            lock.unlock();
+            out << output;
+            lock.lock();
+            written++;
+            any = true;
+            next = finished.find(written);
+        }
+        return any;
+    }
+};
+
+// the expected perft count for a depth from an EPD line's "D<depth> <nodes>" operation, 0 if it has none
+uint64_t expectedNodes(const string& line, int depth) {
+    string operation = "D" + to_string(depth) + " ";
+    for (size_t at = line.find(operation); at != string::npos; at = line.find(operation, at + 1)) {
+        // only at the start of an operation
+        if (at == 0 || line[at - 1] == ' ' || line[at - 1] == ';')
+            return strtoull(line.c_str() + at + operation.size(), nullptr, 10);
+    }
+    return 0;
+}
+
+class Worker {
+public:
+    explicit Worker(const Options& options) : options(options), table(1), search(game, table) {}
+
+    void Run(Pipeline& pipeline) {
+        Chunk chunk;
+        while (pipeline.Pop(chunk)) {
+            string output;
+            for (const auto& line : chunk.lines)
+                Analyse(line, output);
+            pipeline.Done(chunk.index, move(output));
+        }
+    }
+
+private:
+    const Options& options;
+    // every worker reuses the same Game, table and Search (with its pawn table) for all its positions
+    Game game;
+    TranspositionTable table;
+    Search search;
+
+    void Analyse(const string& line, string& output) {
+        FENError error;
+        size_t operations;
+        if (!game.LoadEPD(line, error, operations)) {
+            output += line + "\terror: " + describe(error) + "\n";
+            return;
+        }
+        // the position's four fields, without the operations
+        size_t end = line.find_last_not_of(' ', operations - 1);
+        output.append(line, 0, end + 1);
+
+        MoveList moves;
+        game.GenerateMoves(game.getToMove(), moves);
+        output += "\t" + to_string(moves.size());
+
+        if (options.perft) {
+            uint64_t nodes = perft(game, options.depth);
+            uint64_t expected = expectedNodes(line.substr(operations), options.depth);
+            output += "\t" + to_string(nodes);
+            if (expected != 0)
+                output += nodes == expected ? "\tok" : "\tFAIL (expected " + to_string(expected) + ")";
+            output += "\n";
+            return;
+        }
+
+        // an empty table for every position, so the results don't depend on which worker got which line
+        // (1 MB, next to nothing beside the search itself)
+        table.Clear();
+        table.NewSearch();
+        search.SetPosition(game);
+        SearchLimits limits;
+        limits.depth = options.depth;
+        SearchResult result = search.Run(limits);
+
+        output += "\t" + (result.pv.empty() ? string("-") : moveName(result.pv[0]));
+        if (Search::isMate(result.score)) {
+            int plies = Search::MATE - abs(result.score);
+            output += "\t#" + to_string(result.score > 0 ? (plies + 1) / 2 : -(plies + 1) / 2);
+        } else
+            output += "\t" + to_string(result.score);
+        output += "\n";
+    }
+};
+
+int main(int argc, char** argv) {
+    Options options;
+    vector<string> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            options.threads = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc)
+            options.depth = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--perft") == 0 && i + 1 < argc) {
+            options.perft = true;
+            options.depth = max(1, atoi(argv[++i]));
+        } else
+            files.push_back(argv[i]);
+    }
+
+    ifstream inFile;
+    ofstream outFile;
+    if (files.size() > 0) {
+        inFile.open(files[0]);
+        if (!inFile) {
+            cerr << "Cannot open " << files[0] << endl;
+            return 1;
+        }
+    }
+    if (files.size() > 1) {
+        outFile.open(files[1]);
+        if (!outFile) {
+            cerr << "Cannot open " << files[1] << endl;
+            return 1;
+        }
+    }
+    istream& in = files.size() > 0 ? static_cast<istream&>(inFile) : cin;
+    ostream& out = files.size() > 1 ? static_cast<ostream&>(outFile) : cout;
+
+    Pipeline pipeline(options.threads);
+    vector<unique_ptr<Worker>> workers;
+    vector<thread> threads;
+    for (int i = 0; i < options.threads; i++) {
+        workers.emplace_back(new Worker(options));
+        threads.emplace_back([&, i] { workers[i]->Run(pipeline); });
+    }
+
+    auto start = chrono::steady_clock::now();
+    uint64_t positions = 0;
+    Chunk chunk;
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        // blank lines and comments have no position
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        chunk.lines.push_back(line);
+        positions++;
+        if (chunk.lines.size() == Pipeline::chunkLines) {
+            pipeline.Push(move(chunk), out);
+            chunk = Chunk();
+        }
+    }
+    if (!chunk.lines.empty())
+        pipeline.Push(move(chunk), out);
+    pipeline.Finish(out);
+
+    for (auto& thread : threads)
+        thread.join();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cerr << positions << " positions  " << seconds << "s  "
+        << static_cast<uint64_t>(seconds > 0 ? positions / seconds : 0) << " positions/s" << endl;
+    return 0;
+}
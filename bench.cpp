@@ -0,0 +1,401 @@
+#include "ChessCLI.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Times the Game's primitives one at a time over the same fixed positions, so a change that
+// slows one of them down shows up even when perft's total hides it.
+// Every benchmark runs once to warm the caches, then is timed several times (samples), each
+// sample long enough to not be noise, and the median is reported.
+//
+// The output is tab-separated, one benchmark per line: name, ns per call, fastest sample, and
+// how far apart the samples were (% of the median). Saved to a file it is a baseline to compare with.
+// Before any timing it makes sure the move cache is used (see checkMoveCache()), exits with 1 if not.
+//
+// usage:
+//   bench [--samples n]                            prints the timings
+//   bench --compare baseline.tsv [--threshold %]   also the change from the baseline, and exits with 1
+//                                                  if anything got more than threshold % (default 10) slower
+//                                                  (the fastest samples are compared, other programs running
+//                                                  only ever make a sample slower)
+//   bench > baseline.tsv                           makes a baseline
+
+using namespace std;
+
+// the perft positions (see perft.cpp), and every position one move after them
+const char* roots[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+struct Sample {
+    Game game;
+    string fen;
+    string placement; // just the pieces, what FEN() reads
+    MoveList moves; // legal moves of the team to move
+    // what LegalMove() is asked: every legal move, and every one backwards (mostly illegal)
+    vector<CompleteMove> candidates;
+    // "Nf3", "e4"... for the quiet moves, which is what discoverMove() understands
+    vector<string> notations;
+    vector<AlgebraicMove> algebraic;
+    PieceMap pieces; // the team to move's, for interpretMove()
+};
+
+struct Benchmark {
+    string name;
+    // runs over every position once and returns how many calls it made
+    function<uint64_t(vector<Sample>&)> pass;
+};
+
+struct Result {
+    string name;
+    double nanoseconds; // per call, the median sample
+    double fastest;
+    double spread; // (slowest - fastest) / median, in %
+};
+
+// everything the benchmarks compute goes in here so that it can't be optimized away
+uint64_t sink = 0;
+
+char pieceLetter(PieceType type) {
+    switch (type) {
+        case PieceType::KNIGHT: return 'N';
+        case PieceType::BISHOP: return 'B';
+        case PieceType::ROOK: return 'R';
+        case PieceType::QUEEN: return 'Q';
+        case PieceType::KING: return 'K';
+        default: return 0;
+    }
+}
+
+Sample makeSample(const Game& game) {
+    Sample position;
+    position.game = game;
+    position.fen = game.ToFEN();
+    position.placement = position.fen.substr(0, position.fen.find(' '));
+    Teams toMove = game.getToMove();
+    game.GenerateMoves(toMove, position.moves);
+    for (const auto& move : position.moves) {
+        position.candidates.push_back(move);
+        CompleteMove backwards = move;
+        swap(backwards.move.from, backwards.move.to);
+        position.candidates.push_back(backwards);
+
+        if (move.moveType.captures || move.moveType.castles || move.moveType.promotes)
+            continue;
+        string notation = squareName(move.move.to);
+        if (char letter = pieceLetter(move.pieceType))
+            notation = letter + notation;
+        position.notations.push_back(notation);
+        position.algebraic.push_back(discoverMove(notation));
+    }
+    position.pieces = game.getTeamPieces(toMove);
+    return position;
+}
+
+vector<Sample> corpus() {
+    vector<Sample> positions;
+    for (const char* fen : roots) {
+        Game game;
+        game.Load(fen);
+        positions.push_back(makeSample(game));
+        MoveList moves;
+        game.GenerateMoves(game.getToMove(), moves);
+        for (const auto& move : moves) {
+            game.MakeMove(move);
+            positions.push_back(makeSample(game));
+            game.UnmakeMove();
+        }
+    }
+    return positions;
+}
+
+// The start position after the knights have gone out and back ten times,
+// so repetitions() has 40 earlier positions to look through
+Game shuffledKnights() {
+    Game game;
+    game.Load(roots[0]);
+    const char* shuffle[] = { "g1f3", "g8f6", "f3g1", "f6g8" };
+    for (int i = 0; i < 40; i++) {
+        MoveList moves;
+        game.GenerateMoves(game.getToMove(), moves);
+        for (const auto& move : moves)
+            if (moveName(move) == shuffle[i % 4]) {
+                game.MakeMove(move);
+                break;
+            }
+    }
+    return game;
+}
+
+// calls one per square of every position
+template <class Query>
+uint64_t everySquare(vector<Sample>& positions, Query query) {
+    for (const Sample& position : positions)
+        for (int y = 0; y < 8; y++)
+            for (int x = 0; x < 8; x++)
+                query(position.game, Square{ x, y });
+    return positions.size() * 64;
+}
+
+vector<Benchmark> benchmarks() {
+    vector<Benchmark> all;
+    all.push_back({ "getPiece", [](vector<Sample>& positions) {
+        return everySquare(positions, [](const Game& game, const Square& square) {
+            sink += reinterpret_cast<uintptr_t>(game.getPiece(square));
+        });
+    } });
+    all.push_back({ "getPieceType", [](vector<Sample>& positions) {
+        return everySquare(positions, [](const Game& game, const Square& square) {
+            sink += static_cast<int>(game.getPieceType(square));
+        });
+    } });
+    all.push_back({ "getPieceTeam", [](vector<Sample>& positions) {
+        return everySquare(positions, [](const Game& game, const Square& square) {
+            sink += static_cast<int>(game.getPieceTeam(square));
+        });
+    } });
+    all.push_back({ "getKing", [](vector<Sample>& positions) {
+        for (const Sample& position : positions) {
+            Square white = position.game.getKing(Teams::WHITE);
+            Square black = position.game.getKing(Teams::BLACK);
+            sink += white.x + white.y + black.x + black.y;
+        }
+        return uint64_t(positions.size() * 2);
+    } });
+    all.push_back({ "LegalMove", [](vector<Sample>& positions) {
+        uint64_t calls = 0;
+        for (const Sample& position : positions) {
+            for (const auto& candidate : position.candidates)
+                sink += position.game.LegalMove(candidate.move, candidate.color, candidate.pieceType).valid;
+            calls += position.candidates.size();
+        }
+        return calls;
+    } });
+    all.push_back({ "isChecked", [](vector<Sample>& positions) {
+        for (const Sample& position : positions)
+            sink += position.game.isChecked(Teams::WHITE) + position.game.isChecked(Teams::BLACK);
+        return uint64_t(positions.size() * 2);
+    } });
+    // one team at a time, so each is timed on its own (hasMoves() answers from the
+    // cache, so this is what it costs the first time it is asked)
+    all.push_back({ "GenerateMoves.white", [](vector<Sample>& positions) {
+        MoveList moves;
+        for (const Sample& position : positions) {
+            position.game.GenerateMoves(Teams::WHITE, moves);
+            sink += moves.size();
+        }
+        return uint64_t(positions.size());
+    } });
+    all.push_back({ "GenerateMoves.black", [](vector<Sample>& positions) {
+        MoveList moves;
+        for (const Sample& position : positions) {
+            position.game.GenerateMoves(Teams::BLACK, moves);
+            sink += moves.size();
+        }
+        return uint64_t(positions.size());
+    } });
+    // after the warm-up pass every team's moves are cached, so this is the lookup
+    // (and what hasMoves() and getWinner() cost after a first call)
+    all.push_back({ "legalMoves.cached", [](vector<Sample>& positions) {
+        for (const Sample& position : positions)
+            sink += position.game.legalMoves(Teams::WHITE).size() + position.game.legalMoves(Teams::BLACK).size();
+        return uint64_t(positions.size() * 2);
+    } });
+    // there is no UpdateHistory(), the history is the undo stack that MakeMove() pushes to
+    // and repetitions() looks back through
+    all.push_back({ "MakeMove+UnmakeMove", [](vector<Sample>& positions) {
+        uint64_t calls = 0;
+        for (Sample& position : positions) {
+            for (const auto& move : position.moves) {
+                position.game.MakeMove(move);
+                sink += position.game.getKey();
+                position.game.UnmakeMove();
+            }
+            calls += position.moves.size();
+        }
+        return calls;
+    } });
+    all.push_back({ "repetitions", [](vector<Sample>& positions) {
+        static const Game game = shuffledKnights();
+        for (size_t i = 0; i < positions.size(); i++)
+            sink += game.repetitions();
+        return uint64_t(positions.size());
+    } });
+    all.push_back({ "FEN", [](vector<Sample>& positions) {
+        for (const Sample& position : positions)
+            sink += FEN(position.placement)[0].size();
+        return uint64_t(positions.size());
+    } });
+    all.push_back({ "Load", [](vector<Sample>& positions) {
+        static Game game;
+        for (const Sample& position : positions)
+            sink += game.Load(position.fen);
+        return uint64_t(positions.size());
+    } });
+    all.push_back({ "ToFEN", [](vector<Sample>& positions) {
+        for (const Sample& position : positions)
+            sink += position.game.ToFEN().size();
+        return uint64_t(positions.size());
+    } });
+    all.push_back({ "discoverMove", [](vector<Sample>& positions) {
+        uint64_t calls = 0;
+        for (const Sample& position : positions) {
+            for (const string& notation : position.notations)
+                sink += discoverMove(notation).to.x;
+            calls += position.notations.size();
+        }
+        return calls;
+    } });
+    all.push_back({ "interpretMove", [](vector<Sample>& positions) {
+        uint64_t calls = 0;
+        for (const Sample& position : positions) {
+            Teams toMove = position.game.getToMove();
+            for (const AlgebraicMove& move : position.algebraic)
+                sink += interpretMove(position.pieces, move, toMove).size();
+            calls += position.algebraic.size();
+        }
+        return calls;
+    } });
+    return all;
+}
+
+// getWinner() and then AttemptMoves() generate the moves once between them, the move is found
+// in what getWinner() left in the cache. (Counted only in a CHESS_STATS build, otherwise this
+// just checks the move is played.)
+bool checkMoveCache() {
+    Game game;
+    game.Load(roots[0]);
+    MoveList moves;
+    game.GenerateMoves(Teams::WHITE, moves);
+    vector<CompleteMove> move = { moves[0] };
+
+    Game::ResetStats();
+    bool played = game.getWinner() == Teams::NONE && game.AttemptMoves(move, Teams::WHITE);
+#if defined(CHESS_STATS)
+    GameStats stats = Game::Stats();
+    return played && stats[Counter::GENERATE_MOVES] == 1 && stats[Counter::MOVE_CACHE_MISS] == 1
+        && stats[Counter::MOVE_CACHE_HIT] == 1;
+#else
+    return played;
+#endif
+}
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+Result measure(const Benchmark& benchmark, vector<Sample>& positions, int samples) {
+    // warm up, and see how many passes make a sample of at least 50ms
+    auto start = chrono::steady_clock::now();
+    benchmark.pass(positions);
+    double once = max(secondsSince(start), 1e-7);
+    int passes = max(1, static_cast<int>(0.05 / once));
+
+    vector<double> timings;
+    for (int sample = 0; sample < samples; sample++) {
+        uint64_t calls = 0;
+        start = chrono::steady_clock::now();
+        for (int pass = 0; pass < passes; pass++)
+            calls += benchmark.pass(positions);
+        timings.push_back(secondsSince(start) * 1e9 / max<uint64_t>(calls, 1));
+    }
+    sort(timings.begin(), timings.end());
+    double median = timings[timings.size() / 2];
+    return { benchmark.name, median, timings.front(), (timings.back() - timings.front()) / median * 100 };
+}
+
+// name -> fastest ns per call, from a file bench wrote
+bool loadBaseline(const string& file, map<string, double>& baseline) {
+    ifstream input(file);
+    if (!input)
+        return false;
+    string line;
+    while (getline(input, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        istringstream fields(line);
+        string name;
+        double median, fastest;
+        if (getline(fields, name, '\t') && fields >> median >> fastest)
+            baseline[name] = fastest;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int samples = 7;
+    double threshold = 10;
+    string baselineFile;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--samples" && i + 1 < argc)
+            samples = max(atoi(argv[++i]), 1);
+        else if (arg == "--compare" && i + 1 < argc)
+            baselineFile = argv[++i];
+        else if (arg == "--threshold" && i + 1 < argc)
+            threshold = atof(argv[++i]);
+        else {
+            cerr << "usage: " << argv[0] << " [--samples n] [--compare baseline.tsv [--threshold %]]" << endl;
+            return 2;
+        }
+    }
+
+    map<string, double> baseline;
+    if (!baselineFile.empty() && !loadBaseline(baselineFile, baseline)) {
+        cerr << "Cannot open " << baselineFile << endl;
+        return 2;
+    }
+    bool comparing = !baselineFile.empty();
+
+    if (!checkMoveCache()) {
+        cerr << "getWinner() and AttemptMoves() generated the moves more than once" << endl;
+        return 1;
+    }
+
+    vector<Sample> positions = corpus();
+    cout << fixed << setprecision(2);
+    cout << "# " << positions.size() << " positions, " << samples << " samples" << endl;
+    cout << "# name\tns/call\tfastest\tspread%" << (comparing ? "\tbaseline fastest\tchange%" : "") << endl;
+
+    int regressions = 0;
+    for (const Benchmark& benchmark : benchmarks()) {
+        Result result = measure(benchmark, positions, samples);
+        cout << result.name << "\t" << result.nanoseconds << "\t" << result.fastest << "\t" << result.spread;
+        if (comparing) {
+            auto before = baseline.find(result.name);
+            if (before == baseline.end()) {
+                cout << "\t-\t-";
+            } else {
+                double change = (result.fastest - before->second) / before->second * 100;
+                cout << "\t" << before->second << "\t" << change;
+                if (change > threshold) {
+                    cout << "\tREGRESSION";
+                    regressions++;
+                }
+            }
+        }
+        cout << endl;
+    }
+    // (so that sink is used)
+    cerr << "# checksum " << sink << endl;
+
+    if (regressions > 0) {
+        cerr << regressions << " benchmark" << (regressions == 1 ? "" : "s") << " more than " << threshold << "% slower than " << baselineFile << endl;
+        return 1;
+    }
+    return 0;
+}
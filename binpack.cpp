@@ -0,0 +1,281 @@
+#include "BinaryFormat.h"
+#include "Chess.h"
+#include "MappedFile.h"
+#include "PGN.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Converts positions and games to the binary format (see BinaryFormat.h) and reads them back.
+//
+// usage:
+//   binpack positions <in.epd> <out.bin>   one FEN/EPD per line
+//   binpack games <in.pgn> <out.bin>       every game that replays
+//   binpack dump <in.bin> [first] [count]  prints records as FEN (and moves)
+//   binpack bench <in.bin>                 loads every position, or replays every game, and reports the speed
+//   binpack check                          packs and unpacks known positions, and makes sure bad records are turned down
+
+using namespace std;
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+GameResult resultOf(string_view tag) {
+    if (tag == "1-0") return GameResult::WHITE_WINS;
+    if (tag == "0-1") return GameResult::BLACK_WINS;
+    if (tag == "1/2-1/2") return GameResult::DRAW;
+    return GameResult::UNKNOWN;
+}
+
+int packPositions(const string& in, const string& out) {
+    ifstream input(in);
+    BinaryWriter writer;
+    if (!input || !writer.Open(out, RecordKind::POSITIONS)) {
+        cerr << "Cannot open " << (input ? out : in) << endl;
+        return 1;
+    }
+
+    uint64_t written = 0, skipped = 0, lineNumber = 0;
+    string line;
+    Position position;
+    FENError error;
+    size_t operations;
+    while (getline(input, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#')
+            continue;
+        // a FEN's clocks are kept, an EPD has none
+        if (!parseFEN(line, position, error) && !parseEPD(line, position, error, operations))
+            skipped++;
+        else if (!writer.WritePosition(position)) {
+            cerr << "line " << lineNumber << ": can't be packed (see packPosition()), skipped" << endl;
+            skipped++;
+        } else
+            written++;
+    }
+    cout << written << " positions written, " << skipped << " lines skipped" << endl;
+    return writer.Close() ? 0 : 1;
+}
+
+int packGames(const string& in, const string& out) {
+    MappedFile input;
+    BinaryWriter writer;
+    if (!input.Open(in) || !writer.Open(out, RecordKind::GAMES)) {
+        cerr << "Cannot open " << (input.isOpen() ? out : in) << endl;
+        return 1;
+    }
+
+    PGNReader reader(input.text());
+    PGNGame pgn;
+    Game game;
+    vector<uint16_t> moves;
+    uint64_t written = 0, skipped = 0;
+    while (reader.Next(pgn)) {
+        string_view fen = pgn.tag("FEN");
+        if (!game.Load(fen.empty() ? START_FEN : fen)) {
+            skipped++;
+            continue;
+        }
+        Position start = game.getPosition();
+
+        moves.clear();
+        MovetextReader movetext(pgn.movetext);
+        string_view san;
+        bool ok = true;
+        while (ok && movetext.Next(san)) {
+            CompleteMove move;
+            ok = resolveSAN(game, san, move) == SANStatus::OK;
+            if (ok) {
+                moves.push_back(packMove(move.move));
+                game.MakeMove(move);
+            }
+        }
+
+        if (!ok)
+            skipped++;
+        else if (!writer.WriteGame(start, moves.data(), static_cast<uint32_t>(moves.size()), resultOf(pgn.tag("Result")))) {
+            cerr << "game " << written + skipped + 1 << ": start can't be packed (see packPosition()), skipped" << endl;
+            skipped++;
+        } else
+            written++;
+    }
+    cout << written << " games written, " << skipped << " skipped" << endl;
+    return writer.Close() ? 0 : 1;
+}
+
+int dump(const BinaryReader& reader, size_t first, size_t count) {
+    const char* results[] = { "*", "1-0", "0-1", "1/2-1/2" };
+    Position position;
+    Game game;
+    for (size_t i = first; i < reader.size() && i < first + count; i++) {
+        if (reader.kind() == RecordKind::POSITIONS) {
+            if (unpackPosition(reader.position(i), position)) {
+                game.SetPosition(position);
+                cout << game.ToFEN() << endl;
+            } else
+                cout << "bad record " << i << endl;
+            continue;
+        }
+
+        const GameHeader& header = reader.game(i);
+        if (!unpackPosition(header.start, position)) {
+            cout << "bad record " << i << endl;
+            continue;
+        }
+        game.SetPosition(position);
+        cout << game.ToFEN() << " ";
+
+        const uint16_t* moves = reader.moves(i);
+        for (uint32_t j = 0; j < header.moveCount; j++) {
+            CompleteMove move;
+            if (!findPackedMove(game, moves[j], move)) {
+                cout << "(bad move)";
+                break;
+            }
+            cout << moveName(move) << " ";
+            game.MakeMove(move);
+        }
+        cout << results[static_cast<int>(header.result) & 3] << endl;
+    }
+    return 0;
+}
+
+int bench(const BinaryReader& reader) {
+    auto start = chrono::steady_clock::now();
+    Position position;
+    Game game;
+    uint64_t records = 0, plies = 0, bad = 0;
+
+    for (size_t i = 0; i < reader.size(); i++) {
+        const PackedPosition& packed = reader.kind() == RecordKind::POSITIONS ? reader.position(i) : reader.game(i).start;
+        if (!unpackPosition(packed, position)) {
+            bad++;
+            continue;
+        }
+        game.SetPosition(position);
+        records++;
+
+        if (reader.kind() == RecordKind::GAMES) {
+            const uint16_t* moves = reader.moves(i);
+            for (uint32_t j = 0; j < reader.game(i).moveCount; j++) {
+                CompleteMove move;
+                if (!findPackedMove(game, moves[j], move)) {
+                    bad++;
+                    break;
+                }
+                game.MakeMove(move);
+                plies++;
+            }
+        }
+    }
+
+    double seconds = secondsSince(start);
+    cout << records << (reader.kind() == RecordKind::POSITIONS ? " positions" : " games") << "  " << plies << " plies  "
+        << bad << " bad  " << seconds << "s  " << static_cast<uint64_t>(seconds > 0 ? records / seconds : 0) << " records/s" << endl;
+    return bad == 0 ? 0 : 1;
+}
+
+// a record with the given team << 3 | PieceType codes on the given squares (lowest square first)
+PackedPosition craft(initializer_list<pair<int, uint8_t>> squares, uint8_t state = 0, int8_t enPassant = -1) {
+    PackedPosition packed = {};
+    int i = 0;
+    for (auto [index, code] : squares) {
+        packed.occupied |= 1ULL << index;
+        packed.pieces[i / 2] |= (i & 1) ? code << 4 : code;
+        i++;
+    }
+    packed.state = state;
+    packed.enPassant = enPassant;
+    packed.fullmoveNumber = 1;
+    return packed;
+}
+
+int check() {
+    const uint8_t K = static_cast<uint8_t>(PieceType::KING), P = static_cast<uint8_t>(PieceType::PAWN);
+    const uint8_t R = static_cast<uint8_t>(PieceType::ROOK), BLACK = Teams::BLACK << 3;
+    int failures = 0;
+
+    // good positions come back the same
+    string_view fens[] = {
+        START_FEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 37 60",
+    };
+    for (string_view fen : fens) {
+        Position position, back;
+        FENError error;
+        PackedPosition packed;
+        bool ok = parseFEN(fen, position, error) && packPosition(position, packed) && unpackPosition(packed, back);
+        Game game, backGame;
+        if (ok) {
+            game.SetPosition(position);
+            backGame.SetPosition(back);
+            ok = backGame.ToFEN() == game.ToFEN();
+        }
+        cout << (ok ? "ok   " : "FAIL ") << fen << endl;
+        failures += !ok;
+    }
+
+    // more than 32 pieces doesn't fit
+    Position crowded;
+    FENError error;
+    PackedPosition packed;
+    bool turnedDown = parseFEN("qqqqkqqq/qqqqqqqq/q7/8/8/8/QQQQQQQQ/QQQQKQQQ w - - 0 1", crowded, error)
+        && !packPosition(crowded, packed);
+    cout << (turnedDown ? "ok   " : "FAIL ") << "33 pieces not packed" << endl;
+    failures += !turnedDown;
+
+    // and records that aren't positions don't load (e1 = 4, e8 = 60)
+    struct { const char* name; PackedPosition packed; } bad[] = {
+        { "no white king", craft({ { 60, BLACK | K } }) },
+        { "two black kings", craft({ { 4, K }, { 59, BLACK | K }, { 60, BLACK | K } }) },
+        { "pawn on the first rank", craft({ { 3, P }, { 4, K }, { 60, BLACK | K } }) },
+        { "pawn on the last rank", craft({ { 4, K }, { 60, BLACK | K }, { 61, BLACK | P } }) },
+        { "castling without the rook", craft({ { 4, K }, { 60, BLACK | K } }, WHITE_SHORT << 1) },
+        { "castling with the king moved", craft({ { 5, K }, { 7, R }, { 60, BLACK | K } }, WHITE_SHORT << 1) },
+        { "en passant on the wrong rank", craft({ { 4, K }, { 60, BLACK | K } }, 0, 20) },
+        { "unknown piece", craft({ { 4, K }, { 30, 7 }, { 60, BLACK | K } }) },
+    };
+    for (const auto& record : bad) {
+        Position position;
+        bool rejected = !unpackPosition(record.packed, position);
+        cout << (rejected ? "ok   " : "FAIL ") << record.name << " turned down" << endl;
+        failures += !rejected;
+    }
+
+    cout << failures << " failures" << endl;
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    string mode = argc > 1 ? argv[1] : "";
+    if (mode == "positions" && argc == 4)
+        return packPositions(argv[2], argv[3]);
+    if (mode == "games" && argc == 4)
+        return packGames(argv[2], argv[3]);
+    if (mode == "check")
+        return check();
+
+    if ((mode == "dump" || mode == "bench") && argc >= 3) {
+        BinaryReader reader;
+        if (!reader.Open(argv[2])) {
+            cerr << "Cannot read " << argv[2] << endl;
+            return 1;
+        }
+        if (mode == "bench")
+            return bench(reader);
+        size_t first = argc > 3 ? strtoull(argv[3], nullptr, 10) : 0;
+        size_t count = argc > 4 ? strtoull(argv[4], nullptr, 10) : reader.size();
+        return dump(reader, first, count);
+    }
+
+    cerr << "usage: binpack positions <in.epd> <out.bin> | games <in.pgn> <out.bin> | dump <in.bin> [first] [count] | bench <in.bin> | check" << endl;
+    return 1;
+}
@@ -0,0 +1,112 @@
+#include "Chess.h"
+#include "Evaluator.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Times the Evaluator with every eval kernel this CPU supports (see EvalKernels.h),
+// over the same positions, and checks they all agree. The pawn structure is cached
+// (see PawnHashTable.h), so after the first round it is mostly the mobility being timed.
+//
+// usage:
+//   evalbench [--rounds n] [positions.epd]
+//     without a file the positions are every one within 3 plies of a few well-known ones
+
+using namespace std;
+
+struct Sample {
+    Board board;
+    Teams toMove;
+};
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void collect(Game& game, int depth, vector<Sample>& samples) {
+    samples.push_back({ game.getBoard(), game.getToMove() });
+    if (depth == 0)
+        return;
+    MoveList moves;
+    game.GenerateMoves(game.getToMove(), moves);
+    for (const auto& move : moves) {
+        game.MakeMove(move);
+        collect(game, depth - 1, samples);
+        game.UnmakeMove();
+    }
+}
+
+int main(int argc, char** argv) {
+    int rounds = 20;
+    string file;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--rounds" && i + 1 < argc)
+            rounds = max(atoi(argv[++i]), 1);
+        else
+            file = arg;
+    }
+
+    vector<Sample> samples;
+    Game game;
+    if (!file.empty()) {
+        ifstream input(file);
+        if (!input) {
+            cerr << "Cannot open " << file << endl;
+            return 1;
+        }
+        string line;
+        FENError error;
+        size_t operations;
+        while (getline(input, line))
+            if (game.LoadEPD(line, error, operations) || game.Load(line))
+                samples.push_back({ game.getBoard(), game.getToMove() });
+    } else {
+        const char* fens[] = {
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        };
+        for (const char* fen : fens) {
+            game.Load(fen);
+            collect(game, 3, samples);
+        }
+    }
+    if (samples.empty()) {
+        cerr << "No positions" << endl;
+        return 1;
+    }
+    cout << samples.size() << " positions, " << rounds << " rounds" << endl;
+
+    int64_t expected = 0;
+    bool agree = true;
+    for (EvalKernel kernel : { EvalKernel::SCALAR, EvalKernel::SSE4, EvalKernel::AVX2 }) {
+        if (!kernelSupported(kernel)) {
+            cout << kernelName(kernel) << "\tnot supported" << endl;
+            continue;
+        }
+
+        Evaluator evaluator(kernel);
+        // the sum of every score, so the work can't be optimized away, and to compare the kernels with
+        int64_t sum = 0;
+        auto start = chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++)
+            for (const Sample& sample : samples)
+                sum += evaluator.Evaluate(sample.board, sample.toMove);
+        double seconds = secondsSince(start);
+
+        if (kernel == EvalKernel::SCALAR)
+            expected = sum;
+        bool same = sum == expected;
+        agree = agree && same;
+        uint64_t evaluations = uint64_t(samples.size()) * rounds;
+        cout << kernelName(kernel) << "\t" << static_cast<uint64_t>(evaluations / seconds) << " evals/s\t"
+            << seconds << "s\tpawn hash hits " << static_cast<int>(evaluator.pawnStats().hitRate() * 100) << "%" << (same ? "" : "\tDIFFERENT SCORES") << (kernel == bestKernel() ? "\t(used)" : "") << endl;
+    }
+    return agree ? 0 : 1;
+}
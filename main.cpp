@@ -39,6 +39,7 @@ int main () {
             if (tomove == Teams::WHITE) tomove = Teams::BLACK;
             else tomove = Teams::WHITE;
         }
+        else cout << "That is not a legal move." << endl;
         
         winner = game.getWinner();
     }
@@ -0,0 +1,214 @@
+#include "Chess.h"
+#include "SAN.h"
+#include "Search.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Perft walks the legal move tree to a fixed depth and counts the leaves.
+// The counts for the positions below are known, so any difference means the
+// move generator (or the move path) is broken, and the time tells us how fast it is.
+// The suite also checks every root move comes back the same through SAN (see SAN.h).
+//
+// usage:
+//   perft "<fen>" <depth>    prints every root move with its node count (a 'divide')
+//   perft --suite [depth]    runs the standard positions up to depth (default 4)
+//   perft --smp [threads] [ms]
+//                            searches the standard positions for ms milliseconds (default 1000) with
+//                            1, 2, 4, ... threads (default every core) and reports the nps speedup
+
+using namespace std;
+
+struct PerftPosition {
+    const char* name;
+    const char* fen;
+    // expected node counts for depth 1, 2, ...; 0 ends the list
+    uint64_t nodes[7];
+};
+
+// https://www.chessprogramming.org/Perft_Results
+const PerftPosition suite[] = {
+    { "start", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        { 20, 400, 8902, 197281, 4865609, 119060324 } },
+    { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        { 48, 2039, 97862, 4085603, 193690690 } },
+    { "position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        { 14, 191, 2812, 43238, 674624, 11030083 } },
+    { "position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        { 6, 264, 9467, 422333, 15833292 } },
+    { "position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        { 44, 1486, 62379, 2103487, 89941194 } },
+    { "position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        { 46, 2079, 89890, 3894594, 164075551 } },
+};
+
+Game loadGame(const string& fen) {
+    Game game;
+    FENError error;
+    if (!game.Load(fen, error))
+        cerr << "Bad FEN, " << describe(error) << endl;
+    return game;
+}
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void reportSpeed(uint64_t nodes, double seconds) {
+    cout << "nodes " << nodes << "  time " << seconds << "s  nps "
+        << static_cast<uint64_t>(seconds > 0 ? nodes / seconds : 0) << endl;
+}
+
+int divide(const string& fen, int depth) {
+    Game game = loadGame(fen);
+
+    auto start = chrono::steady_clock::now();
+    MoveList moves;
+    game.GenerateMoves(game.getToMove(), moves);
+
+    uint64_t total = 0;
+    for (const auto& move : moves) {
+        game.MakeMove(move);
+        uint64_t nodes = perft(game, depth - 1);
+        game.UnmakeMove();
+        cout << moveName(move) << ": " << nodes << endl;
+        total += nodes;
+    }
+
+    cout << endl << "moves " << moves.size() << endl;
+    reportSpeed(total, secondsSince(start));
+    return 0;
+}
+
+// "O-O", "exd5", "e8=Q", and pieces with their whole from square ("Ng1f3")
+string writeSAN(const CompleteMove& move) {
+    if (move.moveType.castles)
+        return move.moveType.castleSide == CastleSide::SHORT ? "O-O" : "O-O-O";
+    const char letters[] = { 0, 'N', 'B', 'R', 'Q', 'K' };
+    string san;
+    if (move.pieceType == PieceType::PAWN) {
+        if (move.moveType.captures)
+            san = squareName(move.move.from).substr(0, 1) + "x";
+    } else
+        san = letters[static_cast<int>(move.pieceType) - static_cast<int>(PieceType::PAWN)] + squareName(move.move.from) + (move.moveType.captures ? "x" : "");
+    san += squareName(move.move.to);
+    if (move.move.promotion != PieceType::NONE)
+        san += string("=") + letters[static_cast<int>(move.move.promotion) - static_cast<int>(PieceType::PAWN)];
+    return san;
+}
+
+// every legal move, written as SAN and resolved again, is the move the generator made
+int checkSAN(const string& name, const string& fen) {
+    Game game = loadGame(fen);
+    MoveList moves;
+    game.GenerateMoves(game.getToMove(), moves);
+
+    int failures = 0;
+    for (const auto& move : moves) {
+        string san = writeSAN(move);
+        CompleteMove resolved;
+        if (resolveSAN(game, san, resolved) != SANStatus::OK || resolved.move != move.move
+            || resolved.moveType != move.moveType || resolved.pieceType != move.pieceType) {
+            cout << "FAIL " << name << " san " << san << " is not " << moveName(move) << endl;
+            failures++;
+        }
+    }
+    if (failures == 0)
+        cout << "ok   " << name << " san: " << moves.size() << " moves" << endl;
+    return failures;
+}
+
+int runSuite(int maxDepth) {
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    auto suiteStart = chrono::steady_clock::now();
+
+    for (const auto& position : suite) {
+        Game game = loadGame(position.fen);
+
+        for (int depth = 1; depth <= maxDepth && position.nodes[depth - 1] != 0; depth++) {
+            auto start = chrono::steady_clock::now();
+            uint64_t nodes = perft(game, depth);
+            double seconds = secondsSince(start);
+            totalNodes += nodes;
+
+            bool ok = nodes == position.nodes[depth - 1];
+            if (!ok)
+                failures++;
+
+            cout << (ok ? "ok   " : "FAIL ") << position.name << " depth " << depth << ": " << nodes;
+            if (!ok)
+                cout << " (expected " << position.nodes[depth - 1] << ")";
+            cout << "  " << static_cast<uint64_t>(seconds > 0 ? nodes / seconds : 0) << " nps" << endl;
+        }
+        failures += checkSAN(position.name, position.fen);
+    }
+    // e8=Q, e8=N... and a capture promoting
+    failures += checkSAN("promotion", "3r3k/4P3/8/8/8/8/8/K7 w - - 0 1");
+
+    cout << endl;
+    reportSpeed(totalNodes, secondsSince(suiteStart));
+    cout << failures << " failures" << endl;
+    return failures == 0 ? 0 : 1;
+}
+
+// Lazy SMP should search (close to) N times as many nodes per second with N threads
+int runScaling(int maxThreads, int64_t movetime) {
+    vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    vector<uint64_t> totalNodes(threadCounts.size(), 0);
+    vector<double> totalSeconds(threadCounts.size(), 0);
+
+    for (const auto& position : suite) {
+        cout << position.name << endl;
+        for (size_t i = 0; i < threadCounts.size(); i++) {
+            Game game = loadGame(position.fen);
+            TranspositionTable table(64);
+            ParallelSearch search(game, table, threadCounts[i]);
+
+            SearchLimits limits;
+            limits.movetime = movetime;
+            SearchResult result = search.Run(limits);
+
+            totalNodes[i] += result.nodes;
+            totalSeconds[i] += result.seconds;
+            cout << "  threads " << threadCounts[i] << "  depth " << result.depth << "  nodes " << result.nodes
+                << "  nps " << static_cast<uint64_t>(result.nodes / result.seconds)
+                << "  pawn hash hits " << static_cast<int>(result.pawns.hitRate() * 100) << "%" << endl;
+        }
+    }
+
+    cout << endl;
+    double baseNps = totalNodes[0] / totalSeconds[0];
+    for (size_t i = 0; i < threadCounts.size(); i++) {
+        double nps = totalNodes[i] / totalSeconds[i];
+        cout << "threads " << threadCounts[i] << "  nps " << static_cast<uint64_t>(nps)
+            << "  speedup " << nps / baseNps << "x" << endl;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "--suite") == 0)
+        return runSuite(argc >= 3 ? stoi(argv[2]) : 4);
+
+    if (argc >= 2 && strcmp(argv[1], "--smp") == 0) {
+        int threads = argc >= 3 ? stoi(argv[2]) : max(1u, thread::hardware_concurrency());
+        return runScaling(threads, argc >= 4 ? stoll(argv[3]) : 1000);
+    }
+
+    if (argc == 3)
+        return divide(argv[1], stoi(argv[2]));
+
+    cerr << "usage: " << argv[0] << " \"<fen>\" <depth>" << endl
+        << "       " << argv[0] << " --suite [depth]" << endl
+        << "       " << argv[0] << " --smp [threads] [ms]" << endl;
+    return 2;
+}
@@ -0,0 +1,185 @@
+#include "Chess.h"
+#include "MappedFile.h"
+#include "PGN.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Replays PGN archives through the move generator on all cores and counts what's in them.
+//
+// usage:
+//   pgn [--threads n] [--errors n] <file.pgn> ...
+//
+// Every move is resolved from its SAN against the legal moves, so a game that replays
+// is a game whose moves are all legal. The first few games that don't are listed
+// (--errors, default 10), then the totals and how many games per second that was.
+
+using namespace std;
+
+struct Totals {
+    uint64_t games = 0;
+    uint64_t plies = 0;
+    uint64_t failed = 0;
+    uint64_t whiteWins = 0, blackWins = 0, draws = 0;
+
+    Totals& operator+=(const Totals& other) {
+        games += other.games;
+        plies += other.plies;
+        failed += other.failed;
+        whiteWins += other.whiteWins;
+        blackWins += other.blackWins;
+        draws += other.draws;
+        return *this;
+    }
+};
+
+// a run of games from one file, numbered from first
+struct Batch {
+    const char* file = nullptr;
+    uint64_t first = 0;
+    vector<PGNGame> games;
+};
+
+// games are read on the calling thread and handed out in batches, only a few batches at a time
+class BatchQueue {
+public:
+    explicit BatchQueue(size_t capacity) : capacity(capacity) {}
+
+    void Push(Batch batch) {
+        unique_lock<mutex> lock(mutex_);
+        notFull.wait(lock, [&] { return batches.size() < capacity; });
+        batches.push_back(move(batch));
+        notEmpty.notify_one();
+    }
+
+    // false once closed and empty
+    bool Pop(Batch& batch) {
+        unique_lock<mutex> lock(mutex_);
+        notEmpty.wait(lock, [&] { return !batches.empty() || closed; });
+        if (batches.empty())
+            return false;
+        batch = move(batches.front());
+        batches.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void Close() {
+        lock_guard<mutex> lock(mutex_);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    mutex mutex_;
+    condition_variable notFull, notEmpty;
+    deque<Batch> batches;
+    size_t capacity;
+    bool closed = false;
+};
+
+int main(int argc, char** argv) {
+    int threadCount = max(1u, thread::hardware_concurrency());
+    uint64_t maxErrors = 10;
+    vector<string> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threadCount = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--errors") == 0 && i + 1 < argc)
+            maxErrors = strtoull(argv[++i], nullptr, 10);
+        else
+            files.push_back(argv[i]);
+    }
+    if (files.empty()) {
+        cerr << "usage: pgn [--threads n] [--errors n] <file.pgn> ..." << endl;
+        return 1;
+    }
+
+    BatchQueue queue(threadCount * 4);
+    mutex errorLock;
+    uint64_t errors = 0;
+    vector<Totals> totals(threadCount);
+    vector<thread> workers;
+
+    for (int i = 0; i < threadCount; i++) {
+        workers.emplace_back([&, i] {
+            Game game;
+            Totals& mine = totals[i];
+            Batch batch;
+            while (queue.Pop(batch)) {
+                for (size_t j = 0; j < batch.games.size(); j++) {
+                    const PGNGame& pgn = batch.games[j];
+                    ReplayResult result = replayGame(pgn, game);
+                    mine.games++;
+                    mine.plies += result.plies;
+
+                    if (result.error.status != SANStatus::OK) {
+                        mine.failed++;
+                        lock_guard<mutex> lock(errorLock);
+                        if (errors++ < maxErrors)
+                            cerr << batch.file << " game " << batch.first + j + 1 << ": " << describe(result.error)
+                                << " '" << result.failed << "' after " << result.plies << " plies" << endl;
+                        continue;
+                    }
+
+                    string_view outcome = pgn.tag("Result");
+                    if (outcome == "1-0") mine.whiteWins++;
+                    else if (outcome == "0-1") mine.blackWins++;
+                    else if (outcome == "1/2-1/2") mine.draws++;
+                }
+            }
+        });
+    }
+
+    auto start = chrono::steady_clock::now();
+    // the files stay mapped until every game in them is replayed
+    vector<unique_ptr<MappedFile>> mapped;
+    for (const auto& file : files) {
+        mapped.emplace_back(new MappedFile());
+        if (!mapped.back()->Open(file)) {
+            cerr << "Cannot open " << file << endl;
+            continue;
+        }
+
+        PGNReader reader(mapped.back()->text());
+        Batch batch;
+        batch.file = file.c_str();
+        uint64_t count = 0;
+        PGNGame game;
+        while (reader.Next(game)) {
+            batch.games.push_back(game);
+            count++;
+            if (batch.games.size() == 64) {
+                queue.Push(move(batch));
+                batch = Batch();
+                batch.file = file.c_str();
+                batch.first = count;
+            }
+        }
+        if (!batch.games.empty())
+            queue.Push(move(batch));
+    }
+    queue.Close();
+    for (auto& worker : workers)
+        worker.join();
+
+    Totals total;
+    for (const auto& mine : totals)
+        total += mine;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "games " << total.games << "  plies " << total.plies << "  failed " << total.failed << endl;
+    cout << "white wins " << total.whiteWins << "  black wins " << total.blackWins << "  draws " << total.draws << endl;
+    cout << "time " << seconds << "s  games/s " << static_cast<uint64_t>(seconds > 0 ? total.games / seconds : 0)
+        << "  plies/s " << static_cast<uint64_t>(seconds > 0 ? total.plies / seconds : 0) << endl;
+    return total.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,237 @@
+#include "Chess.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// The engine speaking UCI on stdin/stdout, for chess GUIs and tournament managers.
+//
+// supported:
+//   uci, isready, ucinewgame, quit
+//   setoption name Hash value <MB>
+//   setoption name Threads value <n>
+//   position startpos|fen <fen> [moves <move> ...]
+//   go [depth <n>] [nodes <n>] [movetime <ms>] [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>] [infinite]
+//   stop
+//
+// The search runs on its own thread, so the input loop is always free to answer isready and stop.
+
+using namespace std;
+
+string lowercase(string text) {
+    transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return tolower(c); });
+    return text;
+}
+
+class Engine {
+public:
+    Engine() { game.Load(START_FEN); }
+    ~Engine() { StopSearch(); }
+
+    // returns false on quit
+    bool Command(const string& line) {
+        istringstream tokens(line);
+        string command;
+        tokens >> command;
+
+        if (command == "uci") {
+            send("id name Chess");
+            send("id author pricedown");
+            send("option name Hash type spin default 16 min 1 max 4096");
+            send("option name Threads type spin default 1 min 1 max 256");
+            send("uciok");
+        } else if (command == "isready")
+            send("readyok");
+        else if (command == "ucinewgame") {
+            StopSearch();
+            tt.Clear();
+        } else if (command == "setoption")
+            SetOption(tokens);
+        else if (command == "position")
+            Position(tokens);
+        else if (command == "go")
+            Go(tokens);
+        else if (command == "stop")
+            StopSearch();
+        else if (command == "quit")
+            return false;
+        return true;
+    }
+
+private:
+    Game game;
+    TranspositionTable tt{ 16 };
+    int threads = 1;
+
+    unique_ptr<ParallelSearch> search;
+    thread searchThread;
+    SearchResult result;
+    // 'go infinite' only answers with a bestmove once it is told to stop
+    bool waitForStop = false;
+
+    // info lines come from the search thread, everything else from the input loop
+    mutex outputLock;
+
+    void send(const string& line) {
+        lock_guard<mutex> lock(outputLock);
+        cout << line << endl;
+    }
+
+    void SetOption(istringstream& tokens) {
+        string token, name, value;
+        tokens >> token; // "name"
+        // names may have spaces in them
+        while (tokens >> token && token != "value")
+            name += (name.empty() ? "" : " ") + token;
+        tokens >> value;
+
+        StopSearch();
+        name = lowercase(name);
+        try {
+            if (name == "hash")
+                tt.Resize(clamp(stoi(value), 1, 4096));
+            else if (name == "threads")
+                threads = clamp(stoi(value), 1, 256);
+            else
+                send("info string unknown option " + name);
+        } catch (const exception&) {
+            send("info string bad value for " + name);
+        }
+    }
+
+    void Position(istringstream& tokens) {
+        StopSearch();
+
+        string token, fen;
+        tokens >> token;
+        if (token == "startpos") {
+            fen = START_FEN;
+            tokens >> token;
+        } else if (token == "fen") {
+            while (tokens >> token && token != "moves")
+                fen += token + " ";
+        } else
+            return;
+        FENError error;
+        if (!game.Load(fen, error)) {
+            send("info string bad fen, " + describe(error));
+            return;
+        }
+
+        if (token != "moves")
+            return;
+
+        // moves are matched against the generated ones by their long algebraic name
+        while (tokens >> token) {
+            MoveList moves;
+            game.GenerateMoves(game.getToMove(), moves);
+            auto move = find_if(moves.begin(), moves.end(),
+                [&](const CompleteMove& legal) { return moveName(legal) == token; });
+            if (move == moves.end()) {
+                send("info string illegal move " + token);
+                return;
+            }
+            game.MakeMove(*move);
+        }
+    }
+
+    void Go(istringstream& tokens) {
+        StopSearch();
+
+        SearchLimits limits;
+        int64_t time[2] = {}, increment[2] = {};
+        int movesToGo = 0;
+        bool infinite = false;
+
+        string token;
+        while (tokens >> token) {
+            if (token == "depth") tokens >> limits.depth;
+            else if (token == "nodes") tokens >> limits.nodes;
+            else if (token == "movetime") tokens >> limits.movetime;
+            else if (token == "wtime") tokens >> time[Teams::WHITE];
+            else if (token == "btime") tokens >> time[Teams::BLACK];
+            else if (token == "winc") tokens >> increment[Teams::WHITE];
+            else if (token == "binc") tokens >> increment[Teams::BLACK];
+            else if (token == "movestogo") tokens >> movesToGo;
+            else if (token == "infinite") infinite = true;
+        }
+
+        // on a clock: an even share of what's left, plus most of the increment,
+        // but always leave some time to spare for the GUI to get the move
+        Teams color = game.getToMove();
+        if (!infinite && limits.movetime == 0 && time[color] > 0) {
+            int64_t budget = time[color] / (movesToGo > 0 ? movesToGo : 30) + increment[color] * 3 / 4;
+            limits.movetime = max<int64_t>(min(budget, time[color] - 50), 1);
+        }
+
+        waitForStop = infinite;
+        search = make_unique<ParallelSearch>(game, tt, threads);
+        search->OnIteration([this](const SearchResult& iteration) { Info(iteration); });
+        searchThread = thread([this, limits] {
+            result = search->Run(limits);
+            if (!waitForStop)
+                BestMove();
+        });
+    }
+
+    // stops the running search (if any) and waits for it
+    void StopSearch() {
+        if (!searchThread.joinable())
+            return;
+        search->Stop();
+        searchThread.join();
+        if (waitForStop)
+            BestMove();
+        search.reset();
+    }
+
+    void Info(const SearchResult& iteration) {
+        ostringstream line;
+        line << "info depth " << iteration.depth;
+        if (Search::isMate(iteration.score)) {
+            // in moves, negative when getting mated
+            int plies = Search::MATE - abs(iteration.score);
+            line << " score mate " << (iteration.score > 0 ? (plies + 1) / 2 : -(plies + 1) / 2);
+        } else
+            line << " score cp " << iteration.score;
+
+        uint64_t milliseconds = static_cast<uint64_t>(iteration.seconds * 1000);
+        uint64_t nps = iteration.seconds > 0 ? static_cast<uint64_t>(iteration.nodes / iteration.seconds) : 0;
+        line << " nodes " << iteration.nodes << " nps " << nps << " hashfull " << tt.hashfull()
+             << " time " << milliseconds << " pv";
+        for (const auto& move : iteration.pv)
+            line << " " << moveName(move);
+        send(line.str());
+    }
+
+    void BestMove() {
+        // "0000" is UCI's null move, for when there is nothing to play
+        if (result.pv.empty()) {
+            send("bestmove 0000");
+            return;
+        }
+        string line = "bestmove " + moveName(result.pv[0]);
+        if (result.pv.size() > 1)
+            line += " ponder " + moveName(result.pv[1]);
+        send(line);
+    }
+};
+
+int main() {
+    // GUIs read our output through a pipe, don't let it sit in a buffer
+    cout.setf(ios::unitbuf);
+
+    Engine engine;
+    string line;
+    while (getline(cin, line)) {
+        if (!engine.Command(line))
+            break;
+    }
+    return 0;
+}